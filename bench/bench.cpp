@@ -0,0 +1,285 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 03:05:18 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+/*
+ * Microbenchmarks of conversion stages: Gif::parse, BitReader, LzwDecoder (at
+ * once and in steps of kStepCodes codes) and generate_bmp are measured
+ * separately on every given file, LZW encoding of its first image (on one
+ * thread and in strips on all CPUs) alongside.
+ *
+ * Usage: bench FILE...
+ * BENCH_TIME environment variable sets minimal time per measurement (seconds).
+ * BENCH_DIR environment variable enables extraction of all images (-e) to
+ * files in that directory with every AsyncWriter backend, e.g. on tmpfs and
+ * on a local disk.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <libgen.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "gif.h"
+#include "lzw.h"
+#include "bmp.h"
+#include "pool.h"
+#include "gif2bmp.h"
+#include "writer.h"
+#include "common.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+/**
+ * @brief  Result of one measurement
+ */
+struct result_t {
+	double seconds;		///< Time of one iteration
+	double bytes;			///< Bytes processed in one iteration
+	double pixels;			///< Pixels processed in one iteration
+};
+
+const size_t kStepCodes = 4096;
+
+static double g_min_time = 0.2;
+static const char * g_extract_dir = NULL;
+static int g_cwd = -1;
+
+/**
+ * @brief  Repeat fn until minimal time elapses
+ *
+ * @return  average time of one run
+ */
+template <typename F>
+static double measure(F fn) {
+	size_t iters = 0;
+	bench_clock::time_point start = bench_clock::now();
+	double elapsed;
+
+	do {
+		fn();
+		iters++;
+		elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+	} while (elapsed < g_min_time);
+
+	return elapsed / iters;
+}
+
+static void report(const char * file, const char * stage, const struct result_t & r) {
+	printf("%-36s %-15s %10.1f MB/s %10.1f Mpix/s\n", file, stage,
+			r.bytes / r.seconds / 1e6, r.pixels / r.seconds / 1e6);
+}
+
+static bool load(const char * path, std::vector<char> & data) {
+	FILE * f = fopen(path, "rb");
+	if (! f) {
+		perror(path);
+		return false;
+	}
+
+	fseek(f, 0, SEEK_END);
+	data.resize(ftell(f));
+	fseek(f, 0, SEEK_SET);
+	bool ok = fread(&data[0], 1, data.size(), f) == data.size();
+	fclose(f);
+	return ok;
+}
+
+static bool parse(Gif & gif, std::vector<char> & data) {
+	gif.reset();
+	FILE * f = fmemopen(&data[0], data.size(), "rb");
+	bool ok = gif.parse(f);
+	fclose(f);
+	return ok;
+}
+
+/**
+ * @brief  Benchmark extraction of all images to files by every writer backend
+ */
+static bool bench_extract(const char * name, std::vector<char> & data, size_t pixels) {
+	static const AsyncWriter::backend_t kBackends[] = {
+		AsyncWriter::kBackendSync, AsyncWriter::kBackendThreads, AsyncWriter::kBackendUring
+	};
+	struct gif2bmp_ctx_t * ctx = new struct gif2bmp_ctx_t;
+	bool ok = true;
+
+	if (chdir(g_extract_dir) != 0) {
+		perror(g_extract_dir);
+		delete ctx;
+		return false;
+	}
+
+	for (size_t i = 0; ok && i < sizeof(kBackends) / sizeof(kBackends[0]); ++i) {
+		AsyncWriter writer(kBackends[i]);
+		if (writer.backend() != kBackends[i])
+			continue;
+
+		struct gif2bmp_out_t out = { NULL, &writer, false, 0, 0, NULL, NULL, 0 };
+		struct gif2bmp_t status = gif2bmp_t();
+		struct result_t r;
+
+		r.pixels = pixels;
+		r.seconds = measure([&]() {
+			FILE * f = fmemopen(&data[0], data.size(), "rb");
+			if (gif2bmp(&status, f, NULL, ctx, &out) != 0)
+				ok = false;
+			fclose(f);
+		});
+		r.bytes = status.bmp_size;
+
+		std::string stage = std::string("extract/") + AsyncWriter::backend_name(kBackends[i]);
+		report(name, stage.c_str(), r);
+	}
+
+	if (fchdir(g_cwd) != 0)
+		ok = false;
+	delete ctx;
+	return ok;
+}
+
+/**
+ * @brief  Benchmark all stages on one file
+ */
+static bool bench_file(const char * path, LzwDecoder & lzw, FILE * null_file) {
+	std::vector<char> data;
+	std::vector<uint8_t> plane;
+	std::vector<uint8_t> row;
+	std::vector<uint8_t> encoded;
+	BufferPool pool;
+	Gif gif(&pool);
+	struct result_t r;
+	size_t count = 0;
+
+	if (! load(path, data))
+		return false;
+
+	std::string name_buf(path);
+	const char * name = basename(&name_buf[0]);
+
+	if (! parse(gif, data)) {
+		fprintf(stderr, "%s: parse failed\n", path);
+		return false;
+	}
+
+	size_t compressed = 0;
+	size_t pixels = 0;
+	for (size_t i = 0; i < gif.num_imgs(); ++i) {
+		GifImgData * img = gif.get_image(i);
+		size_t n = (size_t) img->image_desc.width * img->image_desc.height;
+		compressed += img->compressed.size();
+		pixels += n;
+		if (plane.size() < n)
+			plane.resize(n);
+	}
+
+	r.bytes = data.size();
+	r.pixels = pixels;
+	r.seconds = measure([&]() { parse(gif, data); });
+	report(name, "parse", r);
+
+	r.bytes = compressed;
+	r.seconds = measure([&]() {
+		unsigned sum = 0;
+		for (size_t i = 0; i < gif.num_imgs(); ++i) {
+			GifImgData * img = gif.get_image(i);
+			BitReader bits(&img->compressed[1], img->compressed.size() - 1);
+			unsigned code;
+			while (bits.read(LzwDecoder::kMaxCodeSize, code))
+				sum += code;
+		}
+		if (sum == 1) puts(""); // keep the loop
+	});
+	report(name, "bitreader", r);
+
+	r.seconds = measure([&]() {
+		for (size_t i = 0; i < gif.num_imgs(); ++i)
+			lzw.decode(gif.get_image(i), plane.data(), count);
+	});
+	report(name, "lzw", r);
+
+	r.seconds = measure([&]() {
+		for (size_t i = 0; i < gif.num_imgs(); ++i) {
+			lzw.start(gif.get_image(i), plane.data());
+			while (! lzw.step(kStepCodes))
+				;
+		}
+	});
+	report(name, "lzw-step", r);
+
+	/*
+	 * First image as in plain conversion
+	 */
+	GifImgData * img = gif.get_image(0);
+	lzw.decode(img, plane.data(), count);
+	std::vector<Gif::color_item_t> * table = img->has_local_color_table()
+			? &img->local_color_table : &gif.global_color_table;
+	size_t size = 0;
+
+	unsigned min_size = std::max((unsigned) img->compressed[0], 2U);
+	r.bytes = count;
+	r.pixels = count;
+	r.seconds = measure([&]() { lzw_encode(plane.data(), count, min_size, encoded, 1); });
+	report(name, "lzw-encode", r);
+	r.seconds = measure([&]() { lzw_encode(plane.data(), count, min_size, encoded); });
+	report(name, "lzw-encode-mt", r);
+
+	r.pixels = (double) gif.m_header.screen_width * gif.m_header.screen_height;
+	r.seconds = measure([&]() {
+		generate_bmp(size, &gif, plane.data(), count, table, row, null_file);
+	});
+	r.bytes = size;
+	report(name, "bmp", r);
+
+	if (g_extract_dir)
+		return bench_extract(name, data, pixels);
+
+	return true;
+}
+
+int main(int argc, char * argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s FILE...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (getenv("BENCH_TIME"))
+		g_min_time = atof(getenv("BENCH_TIME"));
+	g_extract_dir = getenv("BENCH_DIR");
+	g_cwd = open(".", O_RDONLY | O_DIRECTORY);
+
+	FILE * null_file = fopen("/dev/null", "wb");
+	if (! null_file) {
+		perror("/dev/null");
+		return EXIT_FAILURE;
+	}
+	setvbuf(null_file, NULL, _IOFBF, 1 << 20);
+
+	/*
+	 * Messages of parser would only add noise
+	 */
+	log_init(kLogQuiet);
+
+	LzwDecoder * lzw = new LzwDecoder;
+	int res = EXIT_SUCCESS;
+	for (int i = 1; i < argc; ++i)
+		if (! bench_file(argv[i], *lzw, null_file))
+			res = EXIT_FAILURE;
+
+	delete lzw;
+	fclose(null_file);
+	return res;
+}
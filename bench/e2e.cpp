@@ -0,0 +1,431 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 04:12:09 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+/*
+ * End-to-end regression suite. Runs the converter on every corpus file,
+ * checks output checksums against goldens and throughput against a baseline.
+ *
+ * Usage: e2e [OPTIONS] FILE...
+ *   -b BINARY     converter to run (default ./gif2bmp)
+ *   -g GOLDEN     golden checksums, "<file> <xxh64>" per line
+ *   -u            write golden checksums instead of checking them
+ *   -r RESULT     write measurements to RESULT (JSON)
+ *   -c BASELINE   compare throughput with BASELINE (JSON written by -r)
+ *   -t PERCENT    allowed throughput regression (default 20)
+ *   -n RUNS       runs per file, the fastest one counts (default 3)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <libgen.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "hash.h"
+
+/**
+ * @brief  Measurement of one file
+ */
+struct run_t {
+	std::string file;
+	double wall;			///< Seconds
+	long rss_kb;			///< Peak resident set of converter
+	size_t bytes;			///< Bytes written
+	uint64_t hash;			///< XXH64 of output
+	double mbps;			///< Output MB/s
+};
+
+static std::string base_name(const char * path) {
+	std::string buf(path);
+	return basename(&buf[0]);
+}
+
+/**
+ * @brief  Request to start converter
+ */
+struct spawn_req_t {
+	char in[1024];
+	char out[1024];
+};
+
+/**
+ * @brief  Result of converter
+ */
+struct spawn_resp_t {
+	int ok;
+	long rss_kb;
+};
+
+/**
+ * @brief  Process starting converters
+ *
+ * Linux adds peak resident set of the process calling exec() to ru_maxrss
+ * of the executed program, also after vfork() or posix_spawn(). Converters
+ * are therefore started by a small process forked before the harness
+ * allocates anything, so that only their own memory is measured.
+ */
+struct spawner_t {
+	pid_t pid;
+	int req;				///< Write end of requests
+	int resp;				///< Read end of results
+};
+
+static bool read_full(int fd, void * buf, size_t len) {
+	char * p = (char *) buf;
+	while (len) {
+		ssize_t n = read(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+static bool write_full(int fd, const void * buf, size_t len) {
+	const char * p = (const char *) buf;
+	while (len) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+/**
+ * @brief  Serve requests of harness until it closes them
+ */
+static void spawner_loop(const char * binary, int req, int resp) {
+	struct spawn_req_t r;
+	while (read_full(req, &r, sizeof(r))) {
+		struct spawn_resp_t result = { 0, 0 };
+		pid_t pid = fork();
+		if (pid == 0) {
+			if (! freopen("/dev/null", "w", stderr))
+				_exit(127);
+			execl(binary, binary, "-i", r.in, "-o", r.out, (char *) NULL);
+			_exit(127);
+		}
+
+		int status;
+		struct rusage usage;
+		if (pid > 0 && wait4(pid, &status, 0, &usage) == pid) {
+			result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+			result.rss_kb = usage.ru_maxrss;
+		}
+		if (! write_full(resp, &result, sizeof(result)))
+			break;
+	}
+}
+
+static bool spawner_start(struct spawner_t & s, const char * binary) {
+	int req[2], resp[2];
+	if (pipe(req) < 0 || pipe(resp) < 0) {
+		perror("pipe");
+		return false;
+	}
+
+	s.pid = fork();
+	if (s.pid < 0) {
+		perror("fork");
+		return false;
+	} else if (s.pid == 0) {
+		close(req[1]);
+		close(resp[0]);
+		spawner_loop(binary, req[0], resp[1]);
+		_exit(0);
+	}
+
+	close(req[0]);
+	close(resp[1]);
+	s.req = req[1];
+	s.resp = resp[0];
+	return true;
+}
+
+static void spawner_stop(struct spawner_t & s) {
+	close(s.req);
+	close(s.resp);
+	waitpid(s.pid, NULL, 0);
+}
+
+/**
+ * @brief  Run converter once
+ *
+ * @return  true when converter succeeded
+ */
+static bool run_once(struct spawner_t & s, const char * in, const char * out, struct run_t & r) {
+	struct spawn_req_t req;
+	struct spawn_resp_t resp;
+	if (strlen(in) >= sizeof(req.in) || strlen(out) >= sizeof(req.out)) {
+		fprintf(stderr, "%s: path too long\n", in);
+		return false;
+	}
+	memset(&req, 0, sizeof(req));
+	strcpy(req.in, in);
+	strcpy(req.out, out);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (! write_full(s.req, &req, sizeof(req)) || ! read_full(s.resp, &resp, sizeof(resp))) {
+		perror("spawner");
+		return false;
+	}
+
+	r.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	r.rss_kb = resp.rss_kb;
+	return resp.ok;
+}
+
+/**
+ * @brief  Hash output file
+ */
+static bool hash_file(const char * path, struct run_t & r) {
+	FILE * f = fopen(path, "rb");
+	if (! f)
+		return false;
+
+	std::vector<char> data;
+	fseek(f, 0, SEEK_END);
+	data.resize(ftell(f));
+	fseek(f, 0, SEEK_SET);
+	bool ok = data.empty() || fread(&data[0], 1, data.size(), f) == data.size();
+	fclose(f);
+
+	r.bytes = data.size();
+	r.hash = xxh64(data.data(), data.size());
+	return ok;
+}
+
+static bool load_golden(const char * path, std::map<std::string, uint64_t> & golden) {
+	FILE * f = fopen(path, "r");
+	if (! f) {
+		perror(path);
+		return false;
+	}
+
+	char name[256];
+	unsigned long long hash;
+	while (fscanf(f, "%255s %llx", name, &hash) == 2)
+		golden[name] = hash;
+
+	fclose(f);
+	return true;
+}
+
+static bool load_baseline(const char * path, std::map<std::string, double> & baseline) {
+	FILE * f = fopen(path, "r");
+	if (! f) {
+		perror(path);
+		return false;
+	}
+
+	/*
+	 * Reads only what write_result() produces: one file object per line
+	 */
+	char line[1024];
+	while (fgets(line, sizeof(line), f)) {
+		char name[256];
+		double mbps;
+		const char * p = strstr(line, "\"file\": \"");
+		const char * q = strstr(line, "\"mbps\": ");
+		if (p && q && sscanf(p, "\"file\": \"%255[^\"]\"", name) == 1
+				&& sscanf(q, "\"mbps\": %lf", &mbps) == 1)
+			baseline[name] = mbps;
+	}
+
+	fclose(f);
+	return true;
+}
+
+static bool write_result(const char * path, const std::vector<struct run_t> & runs,
+		double total_mbps) {
+	FILE * f = fopen(path, "w");
+	if (! f) {
+		perror(path);
+		return false;
+	}
+
+	fprintf(f, "{\n  \"total_mbps\": %.3f,\n  \"files\": [\n", total_mbps);
+	for (size_t i = 0; i < runs.size(); ++i) {
+		const struct run_t & r = runs[i];
+		fprintf(f, "    { \"file\": \"%s\", \"wall\": %.6f, \"rss_kb\": %ld, "
+				"\"bytes\": %zu, \"xxh64\": \"%016llx\", \"mbps\": %.3f }%s\n",
+				r.file.c_str(), r.wall, r.rss_kb, r.bytes,
+				(unsigned long long) r.hash, r.mbps, i + 1 < runs.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+
+	return fclose(f) == 0;
+}
+
+int main(int argc, char * argv[]) {
+	const char * binary = "./gif2bmp";
+	const char * golden_path = NULL;
+	const char * result_path = NULL;
+	const char * baseline_path = NULL;
+	bool update = false;
+	double threshold = 20;
+	unsigned runs_per_file = 3;
+
+	int c;
+	while ((c = getopt(argc, argv, "b:g:ur:c:t:n:")) != -1) {
+		switch (c) {
+			case 'b': binary = optarg; break;
+			case 'g': golden_path = optarg; break;
+			case 'u': update = true; break;
+			case 'r': result_path = optarg; break;
+			case 'c': baseline_path = optarg; break;
+			case 't': threshold = atof(optarg); break;
+			case 'n': runs_per_file = atoi(optarg); break;
+			default: return EXIT_FAILURE;
+		}
+	}
+
+	struct spawner_t spawner;
+	if (! spawner_start(spawner, binary))
+		return EXIT_FAILURE;
+
+	std::map<std::string, uint64_t> golden;
+	std::map<std::string, double> baseline;
+	if (golden_path && ! update && ! load_golden(golden_path, golden))
+		return EXIT_FAILURE;
+	if (baseline_path && access(baseline_path, R_OK) == 0
+			&& ! load_baseline(baseline_path, baseline))
+		return EXIT_FAILURE;
+
+	char out_path[] = "/tmp/gif2bmp-e2e-XXXXXX";
+	int fd = mkstemp(out_path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return EXIT_FAILURE;
+	}
+	close(fd);
+
+	std::vector<struct run_t> runs;
+	double total_bytes = 0, total_wall = 0;
+	unsigned failures = 0;
+
+	for (int i = optind; i < argc; ++i) {
+		struct run_t r, best;
+		long rss_kb = 0;
+		best.wall = -1;
+		r.file = best.file = base_name(argv[i]);
+
+		for (unsigned n = 0; n < runs_per_file; ++n) {
+			if (! run_once(spawner, argv[i], out_path, r) || ! hash_file(out_path, r)) {
+				fprintf(stderr, "FAIL %s: conversion failed\n", r.file.c_str());
+				best.wall = -1;
+				break;
+			}
+			if (best.wall < 0 || r.wall < best.wall)
+				best = r;
+			if (r.rss_kb > rss_kb)
+				rss_kb = r.rss_kb;
+		}
+
+		if (best.wall < 0) {
+			failures++;
+			continue;
+		}
+
+		best.rss_kb = rss_kb;
+		best.mbps = best.bytes / best.wall / 1e6;
+		total_bytes += best.bytes;
+		total_wall += best.wall;
+		runs.push_back(best);
+
+		if (! golden.empty()) {
+			std::map<std::string, uint64_t>::iterator it = golden.find(best.file);
+			if (it == golden.end()) {
+				fprintf(stderr, "FAIL %s: no golden checksum\n", best.file.c_str());
+				failures++;
+			} else if (it->second != best.hash) {
+				fprintf(stderr, "FAIL %s: checksum %016llx, expected %016llx\n",
+						best.file.c_str(), (unsigned long long) best.hash,
+						(unsigned long long) it->second);
+				failures++;
+			}
+		}
+
+		printf("%-36s %9.3f ms %8ld KB %11zu B %9.1f MB/s\n", best.file.c_str(),
+				best.wall * 1e3, best.rss_kb, best.bytes, best.mbps);
+	}
+
+	unlink(out_path);
+	spawner_stop(spawner);
+
+	double total_mbps = total_wall > 0 ? total_bytes / total_wall / 1e6 : 0;
+	printf("%-36s %9.3f ms %23.0f B %9.1f MB/s\n", "TOTAL", total_wall * 1e3,
+			total_bytes, total_mbps);
+
+	if (update && golden_path) {
+		FILE * f = fopen(golden_path, "w");
+		if (! f) {
+			perror(golden_path);
+			return EXIT_FAILURE;
+		}
+		for (size_t i = 0; i < runs.size(); ++i)
+			fprintf(f, "%s %016llx\n", runs[i].file.c_str(), (unsigned long long) runs[i].hash);
+		fclose(f);
+	}
+
+	if (result_path && ! write_result(result_path, runs, total_mbps))
+		return EXIT_FAILURE;
+
+	/*
+	 * Throughput check, whole corpus and every file which is not too short
+	 * to be measured reliably
+	 */
+	if (! baseline.empty()) {
+		double limit = 1 - threshold / 100;
+		double base_total = 0, base_bytes = 0;
+
+		for (size_t i = 0; i < runs.size(); ++i) {
+			std::map<std::string, double>::iterator it = baseline.find(runs[i].file);
+			if (it == baseline.end() || it->second <= 0)
+				continue;
+			base_total += runs[i].bytes / (it->second * 1e6);
+			base_bytes += runs[i].bytes;
+			if (runs[i].wall > 0.1 && runs[i].mbps < it->second * limit) {
+				fprintf(stderr, "SLOW %s: %.1f MB/s, baseline %.1f MB/s\n",
+						runs[i].file.c_str(), runs[i].mbps, it->second);
+				failures++;
+			}
+		}
+
+		if (base_total > 0 && total_mbps < base_bytes / base_total / 1e6 * limit) {
+			fprintf(stderr, "SLOW total: %.1f MB/s, baseline %.1f MB/s\n",
+					total_mbps, base_bytes / base_total / 1e6);
+			failures++;
+		}
+	}
+
+	if (failures) {
+		fprintf(stderr, "%u failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
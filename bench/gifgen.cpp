@@ -0,0 +1,377 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 02:20:44 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+/*
+ * Deterministic generator of synthetic GIF corpus for benchmarks. Every run
+ * produces byte-identical files.
+ *
+ * Usage: gifgen DIR
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+enum content_t { NOISE, FLAT, GRADIENT, DITHER };
+
+static const char * kContentNames[] = { "noise", "flat", "gradient", "dither" };
+
+/**
+ * @brief  Corpus file description
+ */
+struct spec_t {
+	content_t content;
+	unsigned width;
+	unsigned height;
+	unsigned min_code_size;		///< 2..8, palette has 2^min_code_size colors
+	bool interlace;
+	unsigned frames;
+};
+
+/**
+ * @brief  xorshift64*, so that output does not depend on libc rand()
+ */
+class Random {
+public:
+	Random(uint64_t seed) : m_state(seed * 2685821657736338717ULL + 1) { }
+
+	uint32_t next() {
+		m_state ^= m_state >> 12;
+		m_state ^= m_state << 25;
+		m_state ^= m_state >> 27;
+		return (m_state * 2685821657736338717ULL) >> 32;
+	}
+
+private:
+	uint64_t m_state;
+};
+
+/**
+ * @brief  LZW encoder writing GIF sub-blocks
+ */
+class Encoder {
+public:
+	Encoder(std::vector<uint8_t> & out) : m_out(out), m_bits(0), m_count(0) {
+		m_keys.resize(kTableSize);
+		m_codes.resize(kTableSize);
+		m_stamps.resize(kTableSize, 0);
+		m_stamp = 0;
+	}
+
+	void encode(const std::vector<uint8_t> & pixels, unsigned min_size) {
+		const unsigned clear = 1 << min_size;
+		const unsigned eoi = clear + 1;
+
+		m_out.push_back(min_size);
+		m_block_start = m_out.size();
+		m_out.push_back(0);
+
+		reset(clear, min_size);
+		put(clear);
+
+		if (pixels.empty()) {
+			put(eoi);
+			finish();
+			return;
+		}
+
+		unsigned prefix = pixels[0];
+		for (size_t i = 1; i < pixels.size(); ++i) {
+			uint32_t key = (prefix << 8) | pixels[i];
+			int code = find(key);
+			if (code >= 0) {
+				prefix = code;
+				continue;
+			}
+
+			put(prefix);
+			if (m_next < 4096) {
+				insert(key, m_next++);
+				if (m_next - 1 == (1U << m_width) && m_width < 12)
+					m_width++;
+			} else {
+				put(clear);
+				reset(clear, min_size);
+			}
+			prefix = pixels[i];
+		}
+
+		put(prefix);
+		put(eoi);
+		finish();
+	}
+
+private:
+	static const size_t kTableSize = 8192;
+
+	void reset(unsigned clear, unsigned min_size) {
+		m_next = clear + 2;
+		m_width = min_size + 1;
+		m_stamp++;
+	}
+
+	int find(uint32_t key) {
+		for (size_t h = hash(key); ; h = (h + 1) & (kTableSize - 1)) {
+			if (m_stamps[h] != m_stamp)
+				return -1;
+			if (m_keys[h] == key)
+				return m_codes[h];
+		}
+	}
+
+	void insert(uint32_t key, unsigned code) {
+		size_t h = hash(key);
+		while (m_stamps[h] == m_stamp)
+			h = (h + 1) & (kTableSize - 1);
+		m_stamps[h] = m_stamp;
+		m_keys[h] = key;
+		m_codes[h] = code;
+	}
+
+	static size_t hash(uint32_t key) {
+		return (key * 2654435761U) >> 19;
+	}
+
+	void put(unsigned code) {
+		m_bits |= (uint64_t) code << m_count;
+		m_count += m_width;
+		while (m_count >= 8) {
+			byte(m_bits & 0xFF);
+			m_bits >>= 8;
+			m_count -= 8;
+		}
+	}
+
+	void byte(uint8_t b) {
+		if (m_out[m_block_start] == 255) {
+			m_block_start = m_out.size();
+			m_out.push_back(0);
+		}
+		m_out.push_back(b);
+		m_out[m_block_start]++;
+	}
+
+	void finish() {
+		if (m_count)
+			byte(m_bits & 0xFF);
+		m_bits = m_count = 0;
+		if (m_out[m_block_start] == 0)
+			m_out.pop_back();
+		m_out.push_back(0);
+	}
+
+	std::vector<uint8_t> & m_out;
+	std::vector<uint32_t> m_keys;
+	std::vector<uint16_t> m_codes;
+	std::vector<uint32_t> m_stamps;
+	uint32_t m_stamp;
+	uint64_t m_bits;
+	unsigned m_count;
+	unsigned m_next;
+	unsigned m_width;
+	size_t m_block_start;
+};
+
+static void put16(std::vector<uint8_t> & out, unsigned v) {
+	out.push_back(v & 0xFF);
+	out.push_back((v >> 8) & 0xFF);
+}
+
+/**
+ * @brief  Generate indexes of one frame in display order
+ */
+static void render(std::vector<uint8_t> & pixels, const struct spec_t & spec, unsigned frame) {
+	static const unsigned kBayer[4][4] = {
+		{ 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 }
+	};
+	const unsigned colors = 1 << spec.min_code_size;
+	const unsigned w = spec.width, h = spec.height;
+	Random rnd(w * 31 + h * 17 + spec.min_code_size * 7 + frame + 1);
+
+	pixels.resize((size_t) w * h);
+	for (unsigned y = 0; y < h; ++y) {
+		uint8_t * row = &pixels[(size_t) y * w];
+		for (unsigned x = 0; x < w; ++x) {
+			switch (spec.content) {
+				case NOISE:
+					row[x] = rnd.next() & (colors - 1);
+					break;
+				case FLAT:
+					row[x] = (frame + 1) & (colors - 1);
+					break;
+				case GRADIENT:
+					row[x] = ((uint64_t) (x + y + frame) * colors / (w + h)) & (colors - 1);
+					break;
+				case DITHER: {
+					/*
+					 * Gradient between two neighbouring colors, ordered dither
+					 */
+					unsigned v = (uint64_t) (x + frame) * (colors - 1) * 16 / (w ? w : 1);
+					unsigned level = v / 16;
+					row[x] = (level + ((v & 15) > kBayer[y & 3][x & 3])) & (colors - 1);
+					break;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief  Reorder rows to interlaced order
+ */
+static void interlace(std::vector<uint8_t> & pixels, unsigned w, unsigned h) {
+	static const unsigned kStart[] = { 0, 4, 2, 1 };
+	static const unsigned kStep[] = { 8, 8, 4, 2 };
+	std::vector<uint8_t> out;
+
+	out.reserve(pixels.size());
+	for (unsigned pass = 0; pass < 4; ++pass)
+		for (unsigned y = kStart[pass]; y < h; y += kStep[pass])
+			out.insert(out.end(), &pixels[(size_t) y * w], &pixels[(size_t) y * w] + w);
+
+	pixels.swap(out);
+}
+
+/**
+ * @brief  Write GIF described by spec
+ *
+ * @return  true on success
+ */
+static bool generate(const std::string & path, const struct spec_t & spec) {
+	const unsigned colors = 1 << spec.min_code_size;
+	std::vector<uint8_t> out;
+	std::vector<uint8_t> pixels;
+	Random rnd(colors);
+
+	out.insert(out.end(), (const uint8_t *) "GIF89a", (const uint8_t *) "GIF89a" + 6);
+	put16(out, spec.width);
+	put16(out, spec.height);
+	out.push_back(0x80 | ((spec.min_code_size - 1) << 4) | (spec.min_code_size - 1));
+	out.push_back(0);	// background
+	out.push_back(0);	// aspect ratio
+
+	for (unsigned i = 0; i < colors; ++i) {
+		out.push_back(rnd.next() & 0xFF);
+		out.push_back(rnd.next() & 0xFF);
+		out.push_back(rnd.next() & 0xFF);
+	}
+
+	if (spec.frames > 1) {
+		static const uint8_t kNetscape[] = {
+			0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0',
+			0x03, 0x01, 0x00, 0x00, 0x00
+		};
+		out.insert(out.end(), kNetscape, kNetscape + sizeof(kNetscape));
+	}
+
+	for (unsigned frame = 0; frame < spec.frames; ++frame) {
+		if (spec.frames > 1) {
+			// Graphic Control Extension, do not dispose, 100ms
+			out.push_back(0x21);
+			out.push_back(0xF9);
+			out.push_back(0x04);
+			out.push_back(0x04);
+			put16(out, 10);
+			out.push_back(0x00);
+			out.push_back(0x00);
+		}
+
+		out.push_back(0x2C);
+		put16(out, 0);
+		put16(out, 0);
+		put16(out, spec.width);
+		put16(out, spec.height);
+		out.push_back(spec.interlace ? 0x40 : 0x00);
+
+		render(pixels, spec, frame);
+		if (spec.interlace)
+			interlace(pixels, spec.width, spec.height);
+
+		Encoder enc(out);
+		enc.encode(pixels, spec.min_code_size);
+	}
+
+	out.push_back(0x3B);
+
+	FILE * f = fopen(path.c_str(), "wb");
+	if (! f) {
+		perror(path.c_str());
+		return false;
+	}
+	bool ok = fwrite(&out[0], 1, out.size(), f) == out.size();
+	ok = (fclose(f) == 0) && ok;
+	if (! ok)
+		perror(path.c_str());
+	return ok;
+}
+
+/**
+ * @brief  Build list of corpus files
+ */
+static void corpus(std::vector<struct spec_t> & specs) {
+	static const unsigned kSizes[][2] = {
+		{ 16, 16 }, { 64, 64 }, { 640, 480 }, { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 }
+	};
+
+	/*
+	 * Every content, min code size and interlacing on a medium image
+	 */
+	for (unsigned c = NOISE; c <= DITHER; ++c)
+		for (unsigned mcs = 2; mcs <= 8; ++mcs)
+			for (unsigned i = 0; i < 2; ++i) {
+				struct spec_t s = { (content_t) c, 256, 256, mcs, i == 1, 1 };
+				specs.push_back(s);
+			}
+
+	/*
+	 * Sizes from icons to 8k
+	 */
+	for (unsigned c = NOISE; c <= DITHER; ++c)
+		for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i) {
+			struct spec_t s = { (content_t) c, kSizes[i][0], kSizes[i][1], 8, false, 1 };
+			specs.push_back(s);
+		}
+
+	/*
+	 * Animations
+	 */
+	for (unsigned c = NOISE; c <= DITHER; ++c) {
+		struct spec_t s = { (content_t) c, 320, 240, 8, false, 16 };
+		specs.push_back(s);
+	}
+}
+
+int main(int argc, char * argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s DIR\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	mkdir(argv[1], 0755);
+
+	std::vector<struct spec_t> specs;
+	corpus(specs);
+
+	for (size_t i = 0; i < specs.size(); ++i) {
+		const struct spec_t & s = specs[i];
+		char name[128];
+		snprintf(name, sizeof(name), "/%s-%ux%u-c%u%s-f%u.gif", kContentNames[s.content],
+				s.width, s.height, s.min_code_size, s.interlace ? "-i" : "", s.frames);
+		if (! generate(argv[1] + std::string(name), s))
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
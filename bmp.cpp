@@ -0,0 +1,489 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 01:47:12 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+
+#include "bmp.h"
+#include "common.h"
+
+const int kBMPHeaderSize		= 14;
+const int kBMPDIPHeaderSize	= 40;
+const size_t kChunkSize			= 256 << 10;
+
+/**
+ * @brief  Store little endian 16bit value
+ */
+static inline void put16(uint8_t * p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+/**
+ * @brief  Store little endian 32bit value
+ */
+static inline void put32(uint8_t * p, uint32_t v) {
+	p[0] = v & 0xFF;
+	p[1] = (v >> 8) & 0xFF;
+	p[2] = (v >> 16) & 0xFF;
+	p[3] = v >> 24;
+}
+
+/**
+ * @brief  Write BMP headers
+ *
+ * @param out_file output file to write to
+ * @param width width of image
+ * @param height height of image
+ * @param size file size stored to header
+ * @param stride size of row including padding
+ * @param write_time time spent writing output, may be NULL
+ *
+ * @return  true on success
+ */
+static bool write_header(FILE * out_file, size_t width, size_t height, uint32_t size,
+		size_t stride, struct stage_time_t * write_time) {
+	uint8_t header[kBMPHeaderSize + kBMPDIPHeaderSize];
+
+	/*
+	 * Sizes in header have 32 bits
+	 */
+	if (bmp_file_size(width, height) > UINT32_MAX) {
+		err() << "Image " << std::dec << width << "x" << height << " is too big for BMP!\n";
+		return false;
+	}
+
+	memcpy(header, "BM", 2);
+	put32(header + 2, size);
+	put32(header + 6, 0);
+	put32(header + 10, kBMPHeaderSize + kBMPDIPHeaderSize);
+	/*
+	 * DIP Header
+	 */
+	put32(header + 14, kBMPDIPHeaderSize);
+	put32(header + 18, width);
+	put32(header + 22, height);
+	put16(header + 26, 1); // plane
+	put16(header + 28, 24);
+	put32(header + 30, 0);
+	put32(header + 34, stride * height); // raw size
+	put32(header + 38, 2835); // print resolution
+	put32(header + 42, 2835); // print resolution
+	put32(header + 46, 0); // number of colors in palette
+	put32(header + 50, 0); // number of colors in palette
+
+	StageTimer timer(write_time);
+	if (fwrite(header, sizeof(header), 1, out_file) != 1) {
+		err() << "Failed to write output!\n";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Number of bytes written for image
+ *
+ * It differs from size stored to BMP header, which keeps the original formula.
+ *
+ * @param width width of image
+ * @param height height of image
+ *
+ * @return  size of headers and padded rows
+ */
+uint64_t bmp_file_size(size_t width, size_t height) {
+	size_t w = (3 * width) & 0x3;
+	size_t stride = 3 * width + (w ? 4 - w : 0);
+
+	return kBMPHeaderSize + kBMPDIPHeaderSize + (uint64_t) stride * height;
+}
+
+/**
+ * @brief  Number of rows converted before they are written
+ */
+static size_t chunk_rows(size_t stride, size_t height, std::vector<uint8_t> & row) {
+	size_t rows = stride ? kChunkSize / stride : 1;
+	if (rows < 1)
+		rows = 1;
+	if (rows > height)
+		rows = height;
+	if (row.size() < rows * stride)
+		row.resize(rows * stride);
+	return rows;
+}
+
+/**
+ * @brief  Generate BMP image
+ *
+ * @param sizeo output size of BMP image
+ * @param gif Gif from which BMP should be generated
+ * @param indexes Decoded indexes to color table
+ * @param count number of decoded indexes
+ * @param color_table used color table
+ * @param row buffer for BMP rows written at once
+ * @param out_file output file to write to
+ * @param convert_time time spent converting indexes to colors, may be NULL
+ * @param write_time time spent writing output, may be NULL
+ *
+ * @return  true on success
+ */
+bool generate_bmp(size_t & sizeo, const Gif * gif, const uint8_t * indexes, size_t count,
+		const std::vector<Gif::color_item_t> * color_table, std::vector<uint8_t> & row, FILE * out_file,
+		struct stage_time_t * convert_time, struct stage_time_t * write_time) {
+	const size_t width = gif->m_header.screen_width;
+	const size_t height = gif->m_header.screen_height;
+	const size_t colors = color_table->size();
+	size_t w = (3 * width) & 0x3;
+	size_t stride = 3 * width + (w ? 4 - w : 0);
+
+	sizeo = kBMPHeaderSize + kBMPDIPHeaderSize + count * 3 + 4;
+	if (! write_header(out_file, width, height, sizeo, stride, write_time))
+		return false;
+
+	/*
+	 * Rows are converted to a chunk of several rows which is written at once
+	 */
+	size_t chunk = chunk_rows(stride, height, row);
+	size_t bad = 0;
+
+	for (size_t i = 1; i <= height; ) {
+		size_t rows = height - i + 1 < chunk ? height - i + 1 : chunk;
+		{
+			StageTimer timer(convert_time);
+			for (size_t r = 0; r < rows; ++r, ++i) {
+				size_t base = (height - i) * width;
+				uint8_t * p = row.data() + r * stride;
+
+				for (size_t j = 0; j < width; ++j, p += 3) {
+					if (base + j < count && indexes[base + j] < colors) {
+						const Gif::color_item_t & item = (*color_table)[indexes[base + j]];
+						p[0] = item.data.blue;
+						p[1] = item.data.green;
+						p[2] = item.data.red;
+					} else {
+						bad++;
+						p[0] = p[1] = p[2] = 0;
+					}
+				}
+				memset(p, 0, stride - 3 * width);
+			}
+		}
+
+		StageTimer timer(write_time);
+		if (fwrite(row.data(), 1, rows * stride, out_file) != rows * stride) {
+			err() << "Failed to write output!\n";
+			return false;
+		}
+	}
+
+	if (bad)
+		warn() << "Wrong index to color table in " << std::dec << bad
+				<< " pixels, using black color!\n";
+
+	return true;
+}
+
+/**
+ * @brief  Generate BMP image from composited screen
+ *
+ * @param sizeo output size of BMP image
+ * @param width width of screen
+ * @param height height of screen
+ * @param bgr screen, rows top to bottom, 3 bytes per pixel in BMP order
+ * @param row buffer for BMP rows written at once
+ * @param out_file output file to write to
+ * @param write_time time spent writing output, may be NULL
+ *
+ * @return  true on success
+ */
+bool generate_bmp_bgr(size_t & sizeo, size_t width, size_t height, const uint8_t * bgr,
+		std::vector<uint8_t> & row, FILE * out_file, struct stage_time_t * write_time) {
+	size_t w = (3 * width) & 0x3;
+	size_t stride = 3 * width + (w ? 4 - w : 0);
+
+	sizeo = kBMPHeaderSize + kBMPDIPHeaderSize + width * height * 3 + 4;
+	if (! write_header(out_file, width, height, sizeo, stride, write_time))
+		return false;
+
+	size_t chunk = chunk_rows(stride, height, row);
+	StageTimer timer(write_time);
+
+	for (size_t i = 1; i <= height; ) {
+		size_t rows = height - i + 1 < chunk ? height - i + 1 : chunk;
+		for (size_t r = 0; r < rows; ++r, ++i) {
+			uint8_t * p = row.data() + r * stride;
+			memcpy(p, bgr + (height - i) * 3 * width, 3 * width);
+			memset(p + 3 * width, 0, stride - 3 * width);
+		}
+
+		if (fwrite(row.data(), 1, rows * stride, out_file) != rows * stride) {
+			err() << "Failed to write output!\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Factor to downscale image by
+ *
+ * @param width width of image
+ * @param height height of image
+ * @param scale requested factor, 0 or 1 for full size
+ * @param max_dim longest side of output, 0 for no limit
+ *
+ * @return  smallest factor which satisfies both, at least 1
+ */
+unsigned bmp_scale_factor(size_t width, size_t height, unsigned scale, unsigned max_dim) {
+	size_t factor = scale ? scale : 1;
+	size_t side = std::max(width, height);
+
+	if (max_dim && side > max_dim)
+		factor = std::max(factor, (side + max_dim - 1) / max_dim);
+
+	return std::min(factor, std::max(side, (size_t) 1));
+}
+
+/**
+ * @brief  BGR of every index, wrong indexes are black
+ */
+static void make_lut(const std::vector<Gif::color_item_t> * color_table, uint8_t lut[256][3]) {
+	for (size_t i = 0; i < 256; ++i) {
+		if (i < color_table->size()) {
+			lut[i][0] = (*color_table)[i].data.blue;
+			lut[i][1] = (*color_table)[i].data.green;
+			lut[i][2] = (*color_table)[i].data.red;
+		} else {
+			lut[i][0] = lut[i][1] = lut[i][2] = 0;
+		}
+	}
+}
+
+/**
+ * @brief  Write image downscaled by box filter
+ *
+ * Every output pixel is average of factor x factor block of source pixels,
+ * blocks at right and bottom edge can be smaller. Source rows are summed as
+ * they are produced, only sums of one output row are kept.
+ *
+ * @param add_row adds pixels of source row y to sums of output row, 3 per
+ * output pixel in BGR order
+ * @param sums buffer for sums
+ *
+ * @return  true on success
+ */
+template <typename F>
+static bool write_scaled(size_t & sizeo, size_t width, size_t height, unsigned factor, F add_row,
+		std::vector<uint8_t> & row, std::vector<uint64_t> & sums, FILE * out_file,
+		struct stage_time_t * convert_time, struct stage_time_t * write_time) {
+	const size_t out_width = bmp_scaled(width, factor);
+	const size_t out_height = bmp_scaled(height, factor);
+	size_t w = (3 * out_width) & 0x3;
+	size_t stride = 3 * out_width + (w ? 4 - w : 0);
+
+	sizeo = kBMPHeaderSize + kBMPDIPHeaderSize + out_width * out_height * 3 + 4;
+	if (! write_header(out_file, out_width, out_height, sizeo, stride, write_time))
+		return false;
+
+	size_t chunk = chunk_rows(stride, out_height, row);
+	sums.resize(3 * out_width);
+
+	/*
+	 * BMP rows go bottom to top
+	 */
+	for (size_t y = out_height; y > 0; ) {
+		size_t rows = std::min(chunk, y);
+		{
+			StageTimer timer(convert_time);
+			for (size_t r = 0; r < rows; ++r) {
+				size_t top = --y * factor;
+				size_t bottom = std::min(top + factor, height);
+				uint8_t * p = row.data() + r * stride;
+
+				std::fill(sums.begin(), sums.end(), 0);
+				for (size_t i = top; i < bottom; ++i)
+					add_row(i, sums.data());
+
+				for (size_t x = 0; x < out_width; ++x, p += 3) {
+					uint64_t n = (bottom - top) * (std::min((x + 1) * factor, width) - x * factor);
+					p[0] = (sums[3 * x] + n / 2) / n;
+					p[1] = (sums[3 * x + 1] + n / 2) / n;
+					p[2] = (sums[3 * x + 2] + n / 2) / n;
+				}
+				memset(p, 0, stride - 3 * out_width);
+			}
+		}
+
+		StageTimer timer(write_time);
+		if (fwrite(row.data(), 1, rows * stride, out_file) != rows * stride) {
+			err() << "Failed to write output!\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Generate BMP image downscaled by box filter
+ *
+ * @param sizeo output size of BMP image
+ * @param gif Gif from which BMP should be generated
+ * @param indexes Decoded indexes to color table
+ * @param count number of decoded indexes
+ * @param color_table used color table
+ * @param factor output has 1/factor of width and height of screen
+ * @param row buffer for BMP rows written at once
+ * @param sums buffer for sums of output row
+ * @param out_file output file to write to
+ * @param convert_time time spent converting indexes to colors, may be NULL
+ * @param write_time time spent writing output, may be NULL
+ *
+ * @return  true on success
+ */
+bool generate_bmp_scaled(size_t & sizeo, const Gif * gif, const uint8_t * indexes, size_t count,
+		const std::vector<Gif::color_item_t> * color_table, unsigned factor,
+		std::vector<uint8_t> & row, std::vector<uint64_t> & sums, FILE * out_file,
+		struct stage_time_t * convert_time, struct stage_time_t * write_time) {
+	const size_t width = gif->m_header.screen_width;
+	const size_t height = gif->m_header.screen_height;
+	const size_t colors = color_table->size();
+	size_t bad = 0;
+
+	uint8_t lut[256][3];
+	make_lut(color_table, lut);
+
+	bool ok = write_scaled(sizeo, width, height, factor, [&](size_t y, uint64_t * s) {
+		const size_t base = y * width;
+		const size_t valid = base < count ? std::min(width, count - base) : 0;
+		const uint8_t * in = indexes + base;
+
+		bad += width - valid;
+		for (size_t x = 0; x < valid; s += 3) {
+			size_t end = std::min(x + factor, valid);
+			unsigned b = 0, g = 0, r = 0;
+			for (; x < end; ++x) {
+				const uint8_t * p = lut[in[x]];
+				b += p[0];
+				g += p[1];
+				r += p[2];
+				if (in[x] >= colors)
+					bad++;
+			}
+			s[0] += b;
+			s[1] += g;
+			s[2] += r;
+		}
+	}, row, sums, out_file, convert_time, write_time);
+
+	if (bad)
+		warn() << "Wrong index to color table in " << std::dec << bad
+				<< " pixels, using black color!\n";
+
+	return ok;
+}
+
+/**
+ * @brief  Generate BMP image from composited screen, downscaled by box filter
+ *
+ * @param sizeo output size of BMP image
+ * @param width width of screen
+ * @param height height of screen
+ * @param bgr screen, rows top to bottom, 3 bytes per pixel in BMP order
+ * @param factor output has 1/factor of width and height of screen
+ * @param row buffer for BMP rows written at once
+ * @param sums buffer for sums of output row
+ * @param out_file output file to write to
+ * @param write_time time spent writing output, may be NULL
+ *
+ * @return  true on success
+ */
+bool generate_bmp_bgr_scaled(size_t & sizeo, size_t width, size_t height, const uint8_t * bgr,
+		unsigned factor, std::vector<uint8_t> & row, std::vector<uint64_t> & sums, FILE * out_file,
+		struct stage_time_t * write_time) {
+	return write_scaled(sizeo, width, height, factor, [&](size_t y, uint64_t * s) {
+		const uint8_t * p = bgr + 3 * y * width;
+		for (size_t x = 0; x < width; s += 3) {
+			size_t end = std::min(x + factor, width);
+			for (; x < end; ++x, p += 3) {
+				s[0] += p[0];
+				s[1] += p[1];
+				s[2] += p[2];
+			}
+		}
+	}, row, sums, out_file, NULL, write_time);
+}
+
+/**
+ * @brief  Generate BMP image of which only a rectangle has decoded indexes,
+ * the rest is black
+ *
+ * @param sizeo output size of BMP image
+ * @param width width of image
+ * @param height height of image
+ * @param indexes decoded indexes of rectangle, rows top to bottom
+ * @param count number of decoded indexes
+ * @param place rectangle within image
+ * @param color_table used color table
+ * @param factor output has 1/factor of width and height of image
+ * @param row buffer for BMP rows written at once
+ * @param sums buffer for sums of output row
+ * @param out_file output file to write to
+ * @param convert_time time spent converting indexes to colors, may be NULL
+ * @param write_time time spent writing output, may be NULL
+ *
+ * @return  true on success
+ */
+bool generate_bmp_region(size_t & sizeo, size_t width, size_t height, const uint8_t * indexes,
+		size_t count, const struct region_t & place, const std::vector<Gif::color_item_t> * color_table,
+		unsigned factor, std::vector<uint8_t> & row, std::vector<uint64_t> & sums, FILE * out_file,
+		struct stage_time_t * convert_time, struct stage_time_t * write_time) {
+	const size_t colors = color_table->size();
+	size_t bad = 0;
+	uint8_t lut[256][3];
+
+	make_lut(color_table, lut);
+
+	bool ok = write_scaled(sizeo, width, height, factor, [&](size_t y, uint64_t * s) {
+		if (y < place.top || y >= place.top + place.height)
+			return;
+
+		const size_t base = (y - place.top) * place.width;
+		const size_t valid = base < count ? std::min(place.width, count - base) : 0;
+		const uint8_t * in = indexes + base;
+
+		bad += place.width - valid;
+		s += 3 * (place.left / factor);
+		for (size_t x = 0; x < valid; s += 3) {
+			size_t end = std::min(valid, x + factor - (place.left + x) % factor);
+			unsigned b = 0, g = 0, r = 0;
+			for (; x < end; ++x) {
+				const uint8_t * p = lut[in[x]];
+				b += p[0];
+				g += p[1];
+				r += p[2];
+				if (in[x] >= colors)
+					bad++;
+			}
+			s[0] += b;
+			s[1] += g;
+			s[2] += r;
+		}
+	}, row, sums, out_file, convert_time, write_time);
+
+	if (bad)
+		warn() << "Wrong index to color table in " << std::dec << bad
+				<< " pixels, using black color!\n";
+
+	return ok;
+}
@@ -0,0 +1,54 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 01:47:12 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef BMP_H_
+#define BMP_H_
+
+#include <inttypes.h>
+#include <cstdio>
+
+#include <vector>
+
+#include "gif.h"
+#include "lzw.h"
+#include "timer.h"
+
+uint64_t bmp_file_size(size_t width, size_t height);
+unsigned bmp_scale_factor(size_t width, size_t height, unsigned scale, unsigned max_dim);
+
+/**
+ * @brief  Size of side of image downscaled by factor, partial blocks count
+ */
+inline size_t bmp_scaled(size_t size, unsigned factor) {
+	return (size + factor - 1) / factor;
+}
+
+bool generate_bmp(size_t & sizeo, const Gif * gif, const uint8_t * indexes, size_t count,
+		const std::vector<Gif::color_item_t> * color_table, std::vector<uint8_t> & row, FILE * out_file,
+		struct stage_time_t * convert_time = NULL, struct stage_time_t * write_time = NULL);
+
+bool generate_bmp_bgr(size_t & sizeo, size_t width, size_t height, const uint8_t * bgr,
+		std::vector<uint8_t> & row, FILE * out_file, struct stage_time_t * write_time = NULL);
+
+bool generate_bmp_scaled(size_t & sizeo, const Gif * gif, const uint8_t * indexes, size_t count,
+		const std::vector<Gif::color_item_t> * color_table, unsigned factor,
+		std::vector<uint8_t> & row, std::vector<uint64_t> & sums, FILE * out_file,
+		struct stage_time_t * convert_time = NULL, struct stage_time_t * write_time = NULL);
+
+bool generate_bmp_region(size_t & sizeo, size_t width, size_t height, const uint8_t * indexes,
+		size_t count, const struct region_t & place, const std::vector<Gif::color_item_t> * color_table,
+		unsigned factor, std::vector<uint8_t> & row, std::vector<uint64_t> & sums, FILE * out_file,
+		struct stage_time_t * convert_time = NULL, struct stage_time_t * write_time = NULL);
+
+bool generate_bmp_bgr_scaled(size_t & sizeo, size_t width, size_t height, const uint8_t * bgr,
+		unsigned factor, std::vector<uint8_t> & row, std::vector<uint64_t> & sums, FILE * out_file,
+		struct stage_time_t * write_time = NULL);
+
+#endif // BMP_H_
@@ -0,0 +1,566 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 11:26:40 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+
+#include "bmp2gif.h"
+#include "lzw.h"
+#include "cache.h"
+#include "budget.h"
+#include "trace.h"
+#include "common.h"
+
+const size_t kBMPHeaderSize			= 14;
+const size_t kBMPInfoHeaderSize		= 40;
+const uint32_t kBMPCompressionRGB	= 0;
+const uint32_t kBMPCompressionFields	= 3;
+const size_t kGifMaxSide				= 65535;
+const size_t kGifSubBlockSize			= 255;
+
+/*
+ * Colors of images with more than 256 colors are reduced by median cut over
+ * histogram of 5 bits per channel
+ */
+const unsigned kQuantBits		= 5;
+const size_t kQuantBins			= 1 << (3 * kQuantBits);
+const size_t kMaxColors			= 256;
+
+/**
+ * @brief  Load little endian 16bit value
+ */
+static inline uint16_t get16(const uint8_t * p) {
+	return p[0] | (p[1] << 8);
+}
+
+/**
+ * @brief  Load little endian 32bit value
+ */
+static inline uint32_t get32(const uint8_t * p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/**
+ * @brief  Store little endian 16bit value
+ */
+static inline void put16(std::vector<uint8_t> & out, uint16_t v) {
+	out.push_back(v & 0xFF);
+	out.push_back(v >> 8);
+}
+
+/**
+ * @brief  Pixel rows of BMP
+ */
+struct bmp_rows_t {
+	const uint8_t * data;			///< First row in file
+	size_t stride;
+	size_t width;
+	size_t height;
+	unsigned bpp;
+	bool top_down;
+
+	const uint8_t * row(size_t y) const {
+		return data + (top_down ? y : height - 1 - y) * stride;
+	}
+};
+
+/**
+ * @brief  Box of histogram bins, bounds are inclusive
+ */
+struct quant_box_t {
+	unsigned lo[3];
+	unsigned hi[3];
+	uint64_t count;
+};
+
+static inline size_t quant_bin(const uint8_t * bgr) {
+	return ((size_t) (bgr[2] >> (8 - kQuantBits)) << (2 * kQuantBits))
+			| ((size_t) (bgr[1] >> (8 - kQuantBits)) << kQuantBits)
+			| (bgr[0] >> (8 - kQuantBits));
+}
+
+/**
+ * @brief  Histogram bin of channel values of box
+ */
+static inline size_t box_bin(const unsigned c[3]) {
+	return (c[0] << (2 * kQuantBits)) | (c[1] << kQuantBits) | c[2];
+}
+
+/**
+ * @brief  Shrink box to bins which are used and count its pixels
+ */
+static void shrink_box(struct quant_box_t & box, const std::vector<uint32_t> & hist) {
+	unsigned lo[3] = { 1U << kQuantBits, 1U << kQuantBits, 1U << kQuantBits };
+	unsigned hi[3] = { 0, 0, 0 };
+	unsigned c[3];
+
+	box.count = 0;
+	for (c[0] = box.lo[0]; c[0] <= box.hi[0]; ++c[0])
+		for (c[1] = box.lo[1]; c[1] <= box.hi[1]; ++c[1])
+			for (c[2] = box.lo[2]; c[2] <= box.hi[2]; ++c[2]) {
+				uint32_t n = hist[box_bin(c)];
+				if (! n)
+					continue;
+				box.count += n;
+				for (int k = 0; k < 3; ++k) {
+					lo[k] = std::min(lo[k], c[k]);
+					hi[k] = std::max(hi[k], c[k]);
+				}
+			}
+
+	if (box.count) {
+		memcpy(box.lo, lo, sizeof(lo));
+		memcpy(box.hi, hi, sizeof(hi));
+	}
+}
+
+/**
+ * @brief  Split box at median of its longest side
+ *
+ * @return  false when box is a single bin
+ */
+static bool split_box(struct quant_box_t & box, struct quant_box_t & other,
+		const std::vector<uint32_t> & hist) {
+	int axis = 0;
+	for (int k = 1; k < 3; ++k)
+		if (box.hi[k] - box.lo[k] > box.hi[axis] - box.lo[axis])
+			axis = k;
+	if (box.hi[axis] == box.lo[axis])
+		return false;
+
+	/*
+	 * pixels in every slice along axis
+	 */
+	uint64_t slices[1 << kQuantBits] = { 0 };
+	unsigned c[3];
+	for (c[0] = box.lo[0]; c[0] <= box.hi[0]; ++c[0])
+		for (c[1] = box.lo[1]; c[1] <= box.hi[1]; ++c[1])
+			for (c[2] = box.lo[2]; c[2] <= box.hi[2]; ++c[2])
+				slices[c[axis]] += hist[box_bin(c)];
+
+	unsigned cut = box.lo[axis];
+	uint64_t below = slices[cut];
+	while (cut + 1 < box.hi[axis] && 2 * (below + slices[cut + 1]) <= box.count)
+		below += slices[++cut];
+
+	other = box;
+	box.hi[axis] = cut;
+	other.lo[axis] = cut + 1;
+	shrink_box(box, hist);
+	shrink_box(other, hist);
+	return true;
+}
+
+/**
+ * @brief  Build color table of exactly the colors of image, when it has at
+ * most 256 of them
+ *
+ * @return  false when image has more colors
+ */
+static bool exact_colors(const struct bmp_rows_t & bmp, struct bmp2gif_image_t & image) {
+	const size_t step = bmp.bpp / 8;
+	const size_t kSlots = 1024;
+	uint32_t keys[kSlots];			///< Color + 1, 0 for empty slot
+	uint8_t slots[kSlots];
+	uint32_t last = UINT32_MAX;
+	uint8_t last_index = 0;
+
+	memset(keys, 0, sizeof(keys));
+	image.color_table.clear();
+
+	uint8_t * out = image.indexes.data();
+	for (size_t y = 0; y < bmp.height; ++y) {
+		const uint8_t * p = bmp.row(y);
+		for (size_t x = 0; x < bmp.width; ++x, p += step) {
+			uint32_t color = p[0] | (p[1] << 8) | (p[2] << 16);
+			if (color != last) {
+				size_t h = ((color * 0x9E3779B1U) >> 22) & (kSlots - 1);
+				while (keys[h] && keys[h] != color + 1)
+					h = (h + 1) & (kSlots - 1);
+				if (! keys[h]) {
+					if (image.color_table.size() == kMaxColors)
+						return false;
+					struct Gif::color_item_t item = Gif::color_item_t();
+					item.data.blue = p[0];
+					item.data.green = p[1];
+					item.data.red = p[2];
+					keys[h] = color + 1;
+					slots[h] = image.color_table.size();
+					image.color_table.push_back(item);
+				}
+				last = color;
+				last_index = slots[h];
+			}
+			*out++ = last_index;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Reduce colors of image to 256 by median cut
+ */
+static void quantize(const struct bmp_rows_t & bmp, struct bmp2gif_image_t & image) {
+	const size_t step = bmp.bpp / 8;
+	std::vector<uint32_t> hist(kQuantBins);
+	std::vector<uint64_t> sums(3 * kQuantBins);
+
+	for (size_t y = 0; y < bmp.height; ++y) {
+		const uint8_t * p = bmp.row(y);
+		for (size_t x = 0; x < bmp.width; ++x, p += step) {
+			size_t bin = quant_bin(p);
+			if (hist[bin] == UINT32_MAX)
+				continue;
+			hist[bin]++;
+			sums[3 * bin] += p[0];
+			sums[3 * bin + 1] += p[1];
+			sums[3 * bin + 2] += p[2];
+		}
+	}
+
+	/*
+	 * split the box with most pixels times its longest side until there are
+	 * enough of them, big boxes of few pixels are split too
+	 */
+	std::vector<struct quant_box_t> boxes(1);
+	for (int k = 0; k < 3; ++k) {
+		boxes[0].lo[k] = 0;
+		boxes[0].hi[k] = (1 << kQuantBits) - 1;
+	}
+	shrink_box(boxes[0], hist);
+
+	std::vector<bool> done(1, false);
+	while (boxes.size() < kMaxColors) {
+		size_t best = boxes.size();
+		uint64_t best_weight = 0;
+		for (size_t i = 0; i < boxes.size(); ++i) {
+			const struct quant_box_t & box = boxes[i];
+			unsigned side = std::max(box.hi[0] - box.lo[0],
+					std::max(box.hi[1] - box.lo[1], box.hi[2] - box.lo[2]));
+			uint64_t weight = box.count * (side + 1);
+			if (! done[i] && (best == boxes.size() || weight > best_weight)) {
+				best = i;
+				best_weight = weight;
+			}
+		}
+		if (best == boxes.size())
+			break;
+
+		struct quant_box_t other;
+		if (split_box(boxes[best], other, hist)) {
+			boxes.push_back(other);
+			done.push_back(false);
+		} else {
+			done[best] = true;
+		}
+	}
+
+	/*
+	 * color of box is average of its pixels, every bin maps to its box
+	 */
+	std::vector<uint8_t> lut(kQuantBins, 0);
+	image.color_table.resize(boxes.size());
+	for (size_t i = 0; i < boxes.size(); ++i) {
+		const struct quant_box_t & box = boxes[i];
+		uint64_t sum[3] = { 0, 0, 0 };
+		unsigned c[3];
+
+		for (c[0] = box.lo[0]; c[0] <= box.hi[0]; ++c[0])
+			for (c[1] = box.lo[1]; c[1] <= box.hi[1]; ++c[1])
+				for (c[2] = box.lo[2]; c[2] <= box.hi[2]; ++c[2]) {
+					size_t bin = box_bin(c);
+					lut[bin] = i;
+					for (int k = 0; k < 3; ++k)
+						sum[k] += sums[3 * bin + k];
+				}
+
+		struct Gif::color_item_t & item = image.color_table[i];
+		item = Gif::color_item_t();
+		if (box.count) {
+			item.data.blue = (sum[0] + box.count / 2) / box.count;
+			item.data.green = (sum[1] + box.count / 2) / box.count;
+			item.data.red = (sum[2] + box.count / 2) / box.count;
+		}
+	}
+
+	uint8_t * out = image.indexes.data();
+	for (size_t y = 0; y < bmp.height; ++y) {
+		const uint8_t * p = bmp.row(y);
+		for (size_t x = 0; x < bmp.width; ++x, p += step)
+			*out++ = lut[quant_bin(p)];
+	}
+}
+
+/**
+ * @brief  Unpack indexes of palettized BMP
+ *
+ * @return  number of colors needed, highest index + 1
+ */
+static size_t unpack_indexes(const struct bmp_rows_t & bmp, struct bmp2gif_image_t & image) {
+	const unsigned mask = (1 << bmp.bpp) - 1;
+	uint8_t * out = image.indexes.data();
+	unsigned used = 0;
+
+	for (size_t y = 0; y < bmp.height; ++y) {
+		const uint8_t * p = bmp.row(y);
+		if (bmp.bpp == 8) {
+			memcpy(out, p, bmp.width);
+			for (size_t x = 0; x < bmp.width; ++x)
+				used = std::max(used, (unsigned) out[x]);
+			out += bmp.width;
+			continue;
+		}
+		for (size_t x = 0; x < bmp.width; ++x) {
+			size_t bit = x * bmp.bpp;
+			unsigned index = (p[bit / 8] >> (8 - bmp.bpp - bit % 8)) & mask;
+			used = std::max(used, index);
+			*out++ = index;
+		}
+	}
+
+	return used + 1;
+}
+
+/**
+ * @brief  Parse BMP and convert it to indexes to color table
+ *
+ * Palettized BMPs (1, 4 and 8 bits) keep their palette, 24 and 32 bit ones
+ * get a color table of their colors, quantized when there are more than 256.
+ *
+ * @param data whole BMP file
+ * @param size size of data
+ * @param image output image
+ * @param status status to set color counters of, may be NULL
+ *
+ * @return  true on success
+ */
+bool bmp2gif_read(const uint8_t * data, size_t size, struct bmp2gif_image_t & image,
+		struct bmp2gif_t * status) {
+	if (size < kBMPHeaderSize + kBMPInfoHeaderSize || data[0] != 'B' || data[1] != 'M') {
+		err() << "Input is not BMP!\n";
+		return false;
+	}
+
+	const uint8_t * info = data + kBMPHeaderSize;
+	size_t offset = get32(data + 10);
+	size_t info_size = get32(info);
+	int32_t width = get32(info + 4);
+	int32_t height = get32(info + 8);
+	unsigned bpp = get16(info + 14);
+	uint32_t compression = get32(info + 16);
+	size_t colors = get32(info + 32);
+
+	if (info_size < kBMPInfoHeaderSize || width <= 0 || height == 0 || height == INT32_MIN) {
+		err() << "Unsupported BMP header!\n";
+		return false;
+	}
+
+	struct bmp_rows_t bmp;
+	bmp.width = width;
+	bmp.height = height < 0 ? -height : height;
+	bmp.top_down = height < 0;
+	bmp.bpp = bpp;
+
+	if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 24 && bpp != 32) {
+		err() << "Unsupported BMP with " << std::dec << bpp << " bits per pixel!\n";
+		return false;
+	}
+
+	/*
+	 * 32 bit pixels may have masks, only the usual BGRX layout is supported
+	 */
+	bool fields = compression == kBMPCompressionFields && bpp == 32
+			&& kBMPHeaderSize + kBMPInfoHeaderSize + 12 <= size
+			&& get32(info + kBMPInfoHeaderSize) == 0xFF0000
+			&& get32(info + kBMPInfoHeaderSize + 4) == 0xFF00
+			&& get32(info + kBMPInfoHeaderSize + 8) == 0xFF;
+	if (compression != kBMPCompressionRGB && ! fields) {
+		err() << "Compressed BMP is not supported!\n";
+		return false;
+	}
+
+	if (bmp.width > kGifMaxSide || bmp.height > kGifMaxSide) {
+		err() << "Image " << std::dec << bmp.width << "x" << bmp.height << " is too big for GIF!\n";
+		return false;
+	}
+	if (! limits_check_screen(bmp.width, bmp.height))
+		return false;
+
+	bmp.stride = ((uint64_t) bmp.width * bpp + 31) / 32 * 4;
+	if (offset > size || (uint64_t) bmp.stride * bmp.height > size - offset) {
+		err() << "BMP pixel data are truncated!\n";
+		return false;
+	}
+	bmp.data = data + offset;
+
+	image.width = bmp.width;
+	image.height = bmp.height;
+	image.indexes.resize(bmp.width * bmp.height);
+
+	if (bpp <= 8) {
+		const uint8_t * palette = info + info_size;
+		if (colors == 0 || colors > (1U << bpp))
+			colors = 1 << bpp;
+		if (info_size > size - kBMPHeaderSize || 4 * colors > (size_t) (data + size - palette)) {
+			err() << "BMP palette is truncated!\n";
+			return false;
+		}
+
+		/*
+		 * indexes past palette are black, as when GIF is decoded
+		 */
+		size_t used = std::max(unpack_indexes(bmp, image), colors);
+		image.color_table.assign(used, Gif::color_item_t());
+		for (size_t i = 0; i < colors; ++i) {
+			image.color_table[i].data.blue = palette[4 * i];
+			image.color_table[i].data.green = palette[4 * i + 1];
+			image.color_table[i].data.red = palette[4 * i + 2];
+		}
+	} else if (! exact_colors(bmp, image)) {
+		quantize(bmp, image);
+		if (status)
+			status->quantized = true;
+	}
+
+	if (status) {
+		status->pixels = (uint64_t) image.width * image.height;
+		status->colors = image.color_table.size();
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Write image as GIF89a with global color table and one image
+ *
+ * @param out_file output file
+ * @param image image to write
+ * @param threads maximal number of strips encoded at once, 0 for number of
+ * CPUs
+ * @param status status to add sizes and times to, may be NULL
+ *
+ * @return  true on success
+ */
+bool bmp2gif_write(FILE * out_file, const struct bmp2gif_image_t & image, unsigned threads,
+		struct bmp2gif_t * status) {
+	const size_t colors = std::max(image.color_table.size(), (size_t) 1);
+	unsigned depth = 1;
+	while ((1U << depth) < colors)
+		depth++;
+	const unsigned min_size = std::max(depth, 2U);
+
+	std::vector<uint8_t> codes;
+	{
+		TRACE_SPAN("lzw_encode");
+		StageTimer timer(status ? &status->encode : NULL);
+		if (! lzw_encode(image.indexes.data(), image.indexes.size(), min_size, codes, threads,
+					status ? &status->strips : NULL))
+			return false;
+	}
+
+	StageTimer timer(status ? &status->write : NULL);
+
+	struct Gif::header_t header = {
+		{ 'G', 'I', 'F' }, { '8', '9', 'a' }, (uint16_t) image.width, (uint16_t) image.height,
+		(uint8_t) (0x80 | ((depth - 1) << 4) | (depth - 1)), 0, 0
+	};
+	struct Gif::image_descriptor_t desc = {
+		0, 0, (uint16_t) image.width, (uint16_t) image.height, 0
+	};
+
+	std::vector<uint8_t> out;
+	out.reserve(13 + (3 << depth) + 10 + codes.size() + codes.size() / kGifSubBlockSize + 4);
+
+	out.insert(out.end(), header.signature, header.signature + 3);
+	out.insert(out.end(), header.version, header.version + 3);
+	put16(out, header.screen_width);
+	put16(out, header.screen_height);
+	out.push_back(header.packed);
+	out.push_back(header.background_color);
+	out.push_back(header.aspect_ratio);
+
+	for (size_t i = 0; i < (1U << depth); ++i) {
+		const bool used = i < image.color_table.size();
+		out.push_back(used ? image.color_table[i].data.red : 0);
+		out.push_back(used ? image.color_table[i].data.green : 0);
+		out.push_back(used ? image.color_table[i].data.blue : 0);
+	}
+
+	out.push_back(0x2C);
+	put16(out, desc.left);
+	put16(out, desc.top);
+	put16(out, desc.width);
+	put16(out, desc.height);
+	out.push_back(desc.packed);
+
+	/*
+	 * LZW minimum code size is the first byte of encoded data, codes follow
+	 * in sub-blocks
+	 */
+	out.push_back(codes[0]);
+	for (size_t pos = 1; pos < codes.size(); pos += kGifSubBlockSize) {
+		size_t n = std::min(kGifSubBlockSize, codes.size() - pos);
+		out.push_back(n);
+		out.insert(out.end(), codes.begin() + pos, codes.begin() + pos + n);
+	}
+	out.push_back(0);
+	out.push_back(0x3B);
+
+	if (fwrite(out.data(), 1, out.size(), out_file) != out.size() || fflush(out_file) != 0) {
+		err() << "Failed to write output!\n";
+		return false;
+	}
+
+	if (status)
+		status->gif_size += out.size();
+	return true;
+}
+
+/**
+ * @brief  Convert BMP to GIF
+ *
+ * @param status output status (sizes and timing), may be NULL
+ * @param in_file input file (BMP)
+ * @param out_file output file (GIF)
+ * @param threads maximal number of strips encoded at once, 0 for number of
+ * CPUs
+ *
+ * @return  0 on success
+ */
+int bmp2gif(struct bmp2gif_t * status, FILE * in_file, FILE * out_file, unsigned threads) {
+	std::vector<char> data;
+	struct bmp2gif_image_t image;
+
+	if (status)
+		*status = bmp2gif_t();
+
+	{
+		TRACE_SPAN("read");
+		StageTimer timer(status ? &status->read : NULL);
+		if (! read_all(in_file, data)) {
+			err() << "Failed to read input!\n";
+			return 1;
+		}
+	}
+	if (status)
+		status->bmp_size = data.size();
+
+	bool ok;
+	{
+		TRACE_SPAN("quantize");
+		StageTimer timer(status ? &status->quantize : NULL);
+		ok = bmp2gif_read((const uint8_t *) data.data(), data.size(), image, status);
+	}
+
+	return ok && bmp2gif_write(out_file, image, threads, status) ? 0 : 1;
+}
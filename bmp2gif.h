@@ -0,0 +1,55 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 11:26:40 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef BMP2GIF_H_
+#define BMP2GIF_H_
+
+#include <inttypes.h>
+#include <cstdio>
+
+#include <vector>
+
+#include "gif.h"
+#include "timer.h"
+
+/**
+ * @brief  Sizes of input/output and timing of BMP to GIF conversion
+ */
+struct bmp2gif_t {
+	int64_t bmp_size;
+	int64_t gif_size;
+	uint64_t pixels;
+	unsigned colors;							///< Colors in color table of GIF
+	bool quantized;							///< BMP had more than 256 colors
+	unsigned strips;							///< Strips encoded in parallel
+	struct stage_time_t read;				///< Reading and parsing BMP
+	struct stage_time_t quantize;			///< Building color table and indexes
+	struct stage_time_t encode;			///< LZW encoding
+	struct stage_time_t write;				///< Writing GIF
+};
+
+/**
+ * @brief  Image with color table, as stored in GIF
+ */
+struct bmp2gif_image_t {
+	size_t width;
+	size_t height;
+	std::vector<uint8_t> indexes;							///< Rows top to bottom
+	std::vector<struct Gif::color_item_t> color_table;
+};
+
+bool bmp2gif_read(const uint8_t * data, size_t size, struct bmp2gif_image_t & image,
+		struct bmp2gif_t * status = NULL);
+bool bmp2gif_write(FILE * out_file, const struct bmp2gif_image_t & image,
+		unsigned threads = 0, struct bmp2gif_t * status = NULL);
+
+int bmp2gif(struct bmp2gif_t * status, FILE * in_file, FILE * out_file, unsigned threads = 0);
+
+#endif // BMP2GIF_H_
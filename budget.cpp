@@ -0,0 +1,135 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 09:14:52 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <mutex>
+#include <condition_variable>
+
+#include "budget.h"
+#include "common.h"
+
+struct limits_t g_limits = { 0, 0, 0, 0 };
+
+/**
+ * @brief  Memory taken by all conversions
+ */
+static std::mutex g_budget_lock;
+static std::condition_variable g_budget_freed;
+static uint64_t g_budget_used = 0;
+
+/**
+ * @brief  Set limits of all following conversions
+ *
+ * @param limits limits to use, 0 is no limit
+ */
+void limits_init(const struct limits_t & limits) {
+	g_limits = limits;
+}
+
+/**
+ * @brief  Check size of logical screen, before anything is allocated for it
+ *
+ * @param width width of screen
+ * @param height height of screen
+ *
+ * @return  true when screen is within limits
+ */
+bool limits_check_screen(size_t width, size_t height) {
+	uint64_t pixels = (uint64_t) width * height;
+
+	if (g_limits.max_pixels && pixels > g_limits.max_pixels) {
+		err() << "Screen " << std::dec << width << "x" << height << " has more than "
+				<< g_limits.max_pixels << " pixels!\n";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Check image descriptor, before image data are read
+ *
+ * @param index index of image counted from 0
+ * @param width width of image
+ * @param height height of image
+ * @param decoded pixels of all images up to and including this one
+ *
+ * @return  true when image is within limits
+ */
+bool limits_check_image(size_t index, size_t width, size_t height, uint64_t decoded) {
+	uint64_t pixels = (uint64_t) width * height;
+
+	if (g_limits.max_frames && index >= g_limits.max_frames) {
+		err() << "GIF has more than " << std::dec << g_limits.max_frames << " images!\n";
+		return false;
+	}
+
+	if (g_limits.max_pixels && pixels > g_limits.max_pixels) {
+		err() << "Image " << std::dec << width << "x" << height << " has more than "
+				<< g_limits.max_pixels << " pixels!\n";
+		return false;
+	}
+
+	if (g_limits.max_decoded && decoded > g_limits.max_decoded) {
+		err() << "Images of GIF have more than " << std::dec << g_limits.max_decoded
+				<< " pixels in total!\n";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Make sure at least bytes are reserved
+ *
+ * @param bytes memory needed by conversion in total
+ *
+ * @return  false when bytes do not fit to budget
+ */
+bool MemoryReservation::ensure(uint64_t bytes) {
+	if (! g_limits.memory || bytes <= m_bytes)
+		return true;
+
+	if (bytes > g_limits.memory) {
+		err() << "Conversion needs " << std::dec << (bytes >> 20) << " MB, memory budget is "
+				<< (g_limits.memory >> 20) << " MB!\n";
+		return false;
+	}
+
+	std::unique_lock<std::mutex> guard(g_budget_lock);
+	uint64_t more = bytes - m_bytes;
+
+	if (m_bytes == 0) {
+		while (g_budget_used + more > g_limits.memory)
+			g_budget_freed.wait(guard);
+	} else if (g_budget_used + more > g_limits.memory) {
+		err() << "Memory budget exhausted, conversion needs " << std::dec << (more >> 20)
+				<< " MB more!\n";
+		return false;
+	}
+
+	g_budget_used += more;
+	m_bytes = bytes;
+	return true;
+}
+
+/**
+ * @brief  Return reserved memory to budget
+ */
+void MemoryReservation::release() {
+	if (! m_bytes)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(g_budget_lock);
+		g_budget_used -= m_bytes;
+		m_bytes = 0;
+	}
+	g_budget_freed.notify_all();
+}
@@ -0,0 +1,65 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 09:14:52 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef BUDGET_H_
+#define BUDGET_H_
+
+#include <inttypes.h>
+#include <cstddef>
+
+/**
+ * @brief  Limits of resources conversions may use, 0 is no limit
+ */
+struct limits_t {
+	uint64_t max_pixels;			///< Pixels of logical screen or of one image
+	uint64_t max_frames;			///< Images in one GIF
+	uint64_t max_decoded;		///< Pixels of all images of one GIF
+	uint64_t memory;				///< Bytes of all conversions running at once
+};
+
+extern struct limits_t g_limits;
+
+/**
+ * @brief  Estimate of bytes needed per pixel of screen or image: plane of
+ * indexes and BGR pixels (composited screen or BMP rows)
+ */
+const uint64_t kBytesPerPixel = 4;
+
+void limits_init(const struct limits_t & limits);
+bool limits_check_screen(size_t width, size_t height);
+bool limits_check_image(size_t index, size_t width, size_t height, uint64_t decoded);
+
+/**
+ * @brief  Memory of one conversion taken from the memory budget
+ *
+ * The first reservation waits until other conversions return enough memory,
+ * so conversions over budget are queued instead of running out of memory.
+ * A conversion which already holds memory does not wait for more, that could
+ * deadlock with others doing the same, it fails instead. Memory is returned
+ * when the reservation is destroyed.
+ */
+class MemoryReservation {
+public:
+	MemoryReservation() : m_bytes(0) { }
+	~MemoryReservation() { release(); }
+
+	bool ensure(uint64_t bytes);
+	void release();
+
+	uint64_t bytes() const { return m_bytes; }
+
+private:
+	MemoryReservation(const MemoryReservation &);
+	MemoryReservation & operator=(const MemoryReservation &);
+
+	uint64_t m_bytes;
+}; // class MemoryReservation
+
+#endif // BUDGET_H_
@@ -0,0 +1,297 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 11:20:05 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "bmp.h"
+#include "hash.h"
+#include "pool.h"
+#include "common.h"
+
+const int kBMPSizeOffset = 2;
+const int kBMPDataOffset = 10;
+const int kBMPWidthOffset = 18;
+const int kBMPHeightOffset = 22;
+const size_t kBMPHeadersSize = 54;
+const mode_t kEntryMode = 0644;
+
+/**
+ * @brief  Constructor
+ *
+ * @param max_bytes max size of entries kept in memory, 0 disables memory tier
+ * @param dir directory for on-disk tier, NULL disables it
+ */
+ConvCache::ConvCache(size_t max_bytes, const char * dir)
+	: m_max_bytes(max_bytes), m_dir(dir ? dir : "") {
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/**
+ * @brief  Compute cache key of GIF data
+ *
+ * @param gif GIF bytes
+ * @param len size of GIF
+ *
+ * @return  cache key
+ */
+uint64_t ConvCache::key(const void * gif, size_t len) {
+	return xxh64(gif, len, len);
+}
+
+/**
+ * @brief  Get path of on-disk entry
+ */
+std::string ConvCache::path(uint64_t key) {
+	char name[32];
+	snprintf(name, sizeof(name), "/%016" PRIx64 ".bmp", key);
+	return m_dir + name;
+}
+
+/**
+ * @brief  Put entry to memory tier, evict least recently used ones
+ *
+ * @note  m_lock has to be held
+ */
+void ConvCache::insert(uint64_t key, const entry_t & entry) {
+	if (entry->size() > m_max_bytes || m_index.count(key))
+		return;
+
+	m_lru.push_front(std::make_pair(key, entry));
+	m_index[key] = m_lru.begin();
+	m_stats.bytes += entry->size();
+	m_stats.entries++;
+
+	while (m_stats.bytes > m_max_bytes) {
+		m_stats.bytes -= m_lru.back().second->size();
+		m_stats.entries--;
+		m_index.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+}
+
+/**
+ * @brief  Read little endian 32bit value
+ */
+static inline uint32_t get32(const std::vector<char> & data, size_t pos) {
+	const uint8_t * p = (const uint8_t *) &data[pos];
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/**
+ * @brief  Check that entry read from cache directory is a whole BMP
+ *
+ * Size field of header keeps the original formula, so the length is
+ * checked against dimensions instead.
+ *
+ * @param data entry
+ *
+ * @return  true when entry has BMP magic and length given by its dimensions
+ */
+static bool valid_entry(const std::vector<char> & data) {
+	if (data.size() < kBMPHeadersSize || data[0] != 'B' || data[1] != 'M')
+		return false;
+
+	return get32(data, kBMPDataOffset) == kBMPHeadersSize
+			&& bmp_file_size(get32(data, kBMPWidthOffset), get32(data, kBMPHeightOffset)) == data.size();
+}
+
+/**
+ * @brief  Find converted image
+ *
+ * Entries of cache directory which are not whole BMPs are removed and
+ * reported as missing.
+ *
+ * @param key cache key of GIF
+ *
+ * @return  BMP data or empty pointer when not cached
+ */
+ConvCache::entry_t ConvCache::lookup(uint64_t key) {
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		std::unordered_map<uint64_t, lru_t::iterator>::iterator it = m_index.find(key);
+		if (it != m_index.end()) {
+			m_lru.splice(m_lru.begin(), m_lru, it->second);
+			m_stats.mem_hits++;
+			return it->second->second;
+		}
+	}
+
+	if (! m_dir.empty()) {
+		FILE * f = fopen(path(key).c_str(), "rb");
+		if (f) {
+			std::vector<char> * data = new std::vector<char>;
+			char buf[1 << 16];
+			size_t n;
+			while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+				data->insert(data->end(), buf, buf + n);
+			bool ok = ! ferror(f);
+			fclose(f);
+
+			if (ok && ! valid_entry(*data)) {
+				warn() << "Dropping broken cache entry '" << path(key) << "'\n";
+				unlink(path(key).c_str());
+				ok = false;
+			}
+
+			if (ok) {
+				entry_t entry(data);
+				std::lock_guard<std::mutex> guard(m_lock);
+				m_stats.disk_hits++;
+				insert(key, entry);
+				return entry;
+			}
+			delete data;
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_stats.misses++;
+	return entry_t();
+}
+
+/**
+ * @brief  Store converted image
+ *
+ * @param key cache key of GIF
+ * @param entry BMP data
+ */
+void ConvCache::store(uint64_t key, const entry_t & entry) {
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		insert(key, entry);
+	}
+
+	if (m_dir.empty())
+		return;
+
+	/*
+	 * Write to a temporary file first so that readers never see partial entry,
+	 * its name is unique also among threads storing the same key
+	 */
+	std::string final_path = path(key);
+	std::string tmp_path = final_path + ".XXXXXX";
+
+	int fd = mkstemp(&tmp_path[0]);
+	FILE * f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+	if (! f) {
+		warn() << "Cannot write cache entry '" << tmp_path << "'\n";
+		if (fd >= 0) {
+			close(fd);
+			unlink(tmp_path.c_str());
+		}
+		return;
+	}
+	fchmod(fd, kEntryMode);
+
+	bool ok = fwrite(&(*entry)[0], 1, entry->size(), f) == entry->size();
+	ok = (fclose(f) == 0) && ok;
+	if (! ok || rename(tmp_path.c_str(), final_path.c_str()) != 0) {
+		warn() << "Cannot write cache entry '" << final_path << "'\n";
+		unlink(tmp_path.c_str());
+	}
+}
+
+/**
+ * @brief  Get cache counters
+ */
+struct ConvCache::stats_t ConvCache::stats() {
+	std::lock_guard<std::mutex> guard(m_lock);
+	return m_stats;
+}
+
+/**
+ * @brief  Read whole file to memory
+ *
+ * @param f file to read
+ * @param data output buffer, previous contents are dropped
+ *
+ * @return  true on success
+ */
+bool read_all(FILE * f, std::vector<char> & data) {
+	size_t n, len = 0;
+
+	data.resize(1 << 16);
+	while ((n = fread(&data[len], 1, data.size() - len, f)) > 0) {
+		len += n;
+		if (len == data.size())
+			data.resize(2 * data.size());
+	}
+	data.resize(len);
+
+	return ! ferror(f);
+}
+
+/**
+ * @brief  Convert GIF to BMP, reuse previous result of the same input
+ *
+ * @param cache cache to use
+ * @param status output status, counters are set only when image was converted
+ * @param gif GIF bytes
+ * @param len size of GIF
+ * @param out_file output file (BMP)
+ * @param ctx decoder working storage to reuse, when NULL a temporary one is used
+ *
+ * @return  0 on success
+ */
+int gif2bmp_cached(class ConvCache * cache, struct gif2bmp_t * status,
+		const char * gif, size_t len, FILE * out_file, struct gif2bmp_ctx_t * ctx) {
+	uint64_t allocs = alloc_count();
+	uint64_t key = ConvCache::key(gif, len);
+	ConvCache::entry_t entry = cache->lookup(key);
+
+	if (status)
+		gif2bmp_reset_stats(status);
+
+	if (! entry) {
+		char * bmp = NULL;
+		size_t bmp_len = 0;
+		int res = 1;
+
+		FILE * in_file = fmemopen((void *) gif, len, "rb");
+		FILE * mem_file = open_memstream(&bmp, &bmp_len);
+		if (in_file && mem_file)
+			res = gif2bmp(status, in_file, mem_file, ctx);
+		if (in_file) fclose(in_file);
+		if (mem_file) fclose(mem_file);
+
+		if (res == 0)
+			entry = ConvCache::entry_t(new std::vector<char>(bmp, bmp + bmp_len));
+		free(bmp);
+
+		if (res != 0)
+			return res;
+
+		cache->store(key, entry);
+	}
+
+	{
+		StageTimer timer(status ? &status->stages[kStageWrite] : NULL);
+		if (fwrite(&(*entry)[0], 1, entry->size(), out_file) != entry->size()) {
+			err() << "Failed to write output!\n";
+			return 1;
+		}
+	}
+
+	if (status) {
+		uint32_t size = 0;
+		if (entry->size() >= kBMPSizeOffset + sizeof(size))
+			memcpy(&size, &(*entry)[kBMPSizeOffset], sizeof(size));
+		status->gif_size = len;
+		status->bmp_size = size;
+		status->allocs = alloc_count() - allocs;
+	}
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 11:20:05 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include <inttypes.h>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+#include <list>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "gif2bmp.h"
+
+/**
+ * @brief  Content addressed cache of converted images
+ *
+ * Key is a hash of GIF input bytes, value is the whole BMP output. Entries are
+ * kept in memory (LRU, bounded by size) and optionally in a directory, where
+ * they survive the process.
+ */
+class ConvCache {
+public:
+	typedef std::shared_ptr<const std::vector<char> > entry_t;
+
+	/**
+	 * @brief  Cache counters
+	 */
+	struct stats_t {
+		uint64_t mem_hits;		///< Served from memory
+		uint64_t disk_hits;		///< Served from cache directory
+		uint64_t misses;			///< Not found, had to convert
+		uint64_t entries;			///< Entries in memory
+		uint64_t bytes;			///< Bytes held in memory
+	};
+
+	ConvCache(size_t max_bytes, const char * dir = NULL);
+
+	static uint64_t key(const void * gif, size_t len);
+
+	entry_t lookup(uint64_t key);
+	void store(uint64_t key, const entry_t & entry);
+	struct stats_t stats();
+
+private:
+	typedef std::list< std::pair<uint64_t, entry_t> > lru_t;
+
+	void insert(uint64_t key, const entry_t & entry);
+	std::string path(uint64_t key);
+
+	lru_t m_lru;
+	std::unordered_map<uint64_t, lru_t::iterator> m_index;
+	size_t m_max_bytes;
+	std::string m_dir;
+	struct stats_t m_stats;
+	std::mutex m_lock;
+}; // class ConvCache
+
+bool read_all(FILE * f, std::vector<char> & data);
+
+int gif2bmp_cached(class ConvCache * cache, struct gif2bmp_t * status,
+		const char * gif, size_t len, FILE * out_file, struct gif2bmp_ctx_t * ctx = NULL);
+
+#endif // CACHE_H_
@@ -19,21 +19,34 @@
 #define UNUSED(V)				((void) V)
 #define UNREACHABLE()		assert(0)
 
+/**
+ * @brief  Log levels, messages above current level are dropped
+ */
+enum log_level_t {
+	kLogQuiet,
+	kLogError,
+	kLogWarning,
+	kLogInfo
+};
+
+extern int g_log_level;
+extern bool g_log_tty;
+
+void log_init(int level);
+bool log_parse_level(const char * name, int & level);
+void warn_repeated(const char * msg);
+void log_summary();
+std::ostream & log_null();
+
 /**
  * @brief  Print error
  *
  * @return   std::cerr
  */
 inline std::ostream & err() {
-#ifdef __linux__
-	if (isatty(fileno(stderr)))
-		std::cerr << "\033[1;31mERROR:\e[0m ";
-	else
-		std::cerr << "ERROR: ";
-	return std::cerr;
-#else
-	return std::cerr << "ERROR: ";
-#endif
+	if (g_log_level < kLogError)
+		return log_null();
+	return std::cerr << (g_log_tty ? "\033[1;31mERROR:\e[0m " : "ERROR: ");
 }
 
 /**
@@ -42,15 +55,9 @@ inline std::ostream & err() {
  * @return   std::cerr
  */
 inline std::ostream & warn() {
-#ifdef __linux__
-	if (isatty(fileno(stderr)))
-		std::cerr << "\e[0;33mWARNING:\e[0m ";
-	else
-		std::cerr << "WARNING: ";
-	return std::cerr;
-#else
-	return std::cerr << "WARNING: ";
-#endif
+	if (g_log_level < kLogWarning)
+		return log_null();
+	return std::cerr << (g_log_tty ? "\e[0;33mWARNING:\e[0m " : "WARNING: ");
 }
 
 /**
@@ -59,15 +66,9 @@ inline std::ostream & warn() {
  * @return   std::cerr
  */
 inline std::ostream & info() {
-#ifdef __linux__
-	if (isatty(fileno(stderr)))
-		std::cerr << "\e[0;32mINFO:\e[0m ";
-	else
-		std::cerr << "INFO: ";
-	return std::cerr;
-#else
-	return std::cerr << "INFO: ";
-#endif
+	if (g_log_level < kLogInfo)
+		return log_null();
+	return std::cerr << (g_log_tty ? "\e[0;32mINFO:\e[0m " : "INFO: ");
 }
 
 /**
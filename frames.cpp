@@ -0,0 +1,489 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 09:52:18 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <cerrno>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "frames.h"
+#include "bmp.h"
+#include "cache.h"
+#include "hash.h"
+#include "index.h"
+#include "budget.h"
+#include "trace.h"
+#include "common.h"
+
+/**
+ * @brief  Set up screen of GIF, filled with background color
+ *
+ * @param gif GIF with parsed header
+ * @param view part of logical screen to keep, within screen
+ */
+void Compositor::start(Gif * gif, const struct region_t & view) {
+	m_view = view;
+	m_width = view.width;
+	m_height = view.height;
+	m_background[0] = m_background[1] = m_background[2] = 0;
+
+	if (gif->has_global_color_table()
+			&& gif->m_header.background_color < gif->global_color_table.size()) {
+		const Gif::color_item_t & item = gif->global_color_table[gif->m_header.background_color];
+		m_background[0] = item.data.blue;
+		m_background[1] = item.data.green;
+		m_background[2] = item.data.red;
+	}
+
+	m_screen.resize(3 * m_width * m_height);
+	clear();
+}
+
+/**
+ * @brief  Fill whole screen with background color
+ */
+void Compositor::clear() {
+	fill(m_view.left, m_view.top, m_width, m_height);
+}
+
+/**
+ * @brief  Fill rectangle of logical screen with background color, clipped to
+ * view
+ */
+void Compositor::fill(size_t left, size_t top, size_t width, size_t height) {
+	size_t right = std::min(left + width, m_view.left + m_width);
+	size_t bottom = std::min(top + height, m_view.top + m_height);
+
+	left = std::max(left, m_view.left);
+	top = std::max(top, m_view.top);
+	if (left >= right || top >= bottom)
+		return;
+	right -= m_view.left;
+	bottom -= m_view.top;
+	left -= m_view.left;
+	top -= m_view.top;
+
+	for (size_t y = top; y < bottom; ++y) {
+		uint8_t * p = &m_screen[3 * (y * m_width + left)];
+		for (size_t x = left; x < right; ++x, p += 3) {
+			p[0] = m_background[0];
+			p[1] = m_background[1];
+			p[2] = m_background[2];
+		}
+	}
+}
+
+/**
+ * @brief  Draw decoded image on screen
+ *
+ * @param img image, its rectangle is clipped to view
+ * @param frame metadata of image (transparency and disposal)
+ * @param indexes decoded indexes of region of image, rows top to bottom
+ * @param count number of decoded indexes, missing pixels are not drawn
+ * @param region part of image decoded to indexes
+ * @param color_table color table of image
+ */
+void Compositor::draw(GifImgData * img, const struct gif_frame_info_t & frame,
+		const uint8_t * indexes, size_t count, const struct region_t & region,
+		const std::vector<Gif::color_item_t> * color_table) {
+	const size_t w = region.width;
+	const size_t h = region.height;
+	const size_t left = img->image_desc.left + region.left;
+	const size_t top = img->image_desc.top + region.top;
+	const size_t colors = color_table->size();
+	const int transparent = frame.transparent;
+	size_t bad = 0;
+
+	if (frame.disposal == kDisposalPrevious)
+		m_saved = m_screen;
+
+	/*
+	 * columns and rows of region hidden left and above view
+	 */
+	const size_t skip_x = m_view.left > left ? m_view.left - left : 0;
+	const size_t skip_y = m_view.top > top ? m_view.top - top : 0;
+	const size_t right = std::min(left + w, m_view.left + m_width);
+	const size_t bottom = std::min(top + h, m_view.top + m_height);
+	const size_t visible = right > left + skip_x ? right - left - skip_x : 0;
+
+	for (size_t y = skip_y; top + y < bottom && y * w + skip_x < count && visible; ++y) {
+		const uint8_t * row = indexes + y * w + skip_x;
+		uint8_t * p = &m_screen[3 * ((top + y - m_view.top) * m_width + left + skip_x - m_view.left)];
+		size_t n = std::min(visible, count - y * w - skip_x);
+
+		for (size_t x = 0; x < n; ++x, p += 3) {
+			if (row[x] == transparent)
+				continue;
+			if (row[x] >= colors) {
+				bad++;
+				p[0] = p[1] = p[2] = 0;
+				continue;
+			}
+			const Gif::color_item_t & item = (*color_table)[row[x]];
+			p[0] = item.data.blue;
+			p[1] = item.data.green;
+			p[2] = item.data.red;
+		}
+	}
+
+	if (bad)
+		warn() << "Wrong index to color table in " << std::dec << bad
+				<< " pixels, using black color!\n";
+}
+
+/**
+ * @brief  Apply disposal method of image after it was displayed
+ *
+ * @param frame metadata of image
+ */
+void Compositor::dispose(const struct gif_frame_info_t & frame) {
+	if (frame.disposal == kDisposalBackground)
+		fill(frame.left, frame.top, frame.width, frame.height);
+	else if (frame.disposal == kDisposalPrevious && m_saved.size() == m_screen.size())
+		m_screen.swap(m_saved);
+}
+
+/**
+ * @brief  Parse frame number, unsigned decimal without sign
+ *
+ * @param p position in selection, moved past the number
+ * @param value parsed number
+ *
+ * @return  false when there is no number or it does not fit in unsigned
+ */
+static bool parse_frame_number(const char *& p, unsigned & value) {
+	if (*p < '0' || *p > '9')
+		return false;
+
+	char * end;
+	errno = 0;
+	unsigned long n = strtoul(p, &end, 10);
+	if (errno == ERANGE || n > UINT_MAX)
+		return false;
+
+	value = n;
+	p = end;
+	return true;
+}
+
+/**
+ * @brief  Parse frame selection like "3", "2-5", "7-" or "1,4-6"
+ *
+ * @param spec selection, frames are counted from 1
+ * @param ranges output ranges
+ *
+ * @return  true on success
+ */
+bool parse_frame_ranges(const char * spec, std::vector<struct frame_range_t> & ranges) {
+	const char * p = spec;
+
+	ranges.clear();
+	do {
+		struct frame_range_t r;
+
+		if (! parse_frame_number(p, r.first) || r.first == 0)
+			return false;
+		r.last = r.first;
+
+		if (*p == '-') {
+			p++;
+			if (*p == ',' || *p == '\0') {
+				r.last = UINT_MAX;
+			} else {
+				if (! parse_frame_number(p, r.last) || r.last < r.first)
+					return false;
+			}
+		}
+
+		ranges.push_back(r);
+	} while (*p++ == ',');
+
+	return *(p - 1) == '\0';
+}
+
+/**
+ * @brief  Whether a frame is selected
+ *
+ * @param i frame index counted from 0
+ */
+static bool selected(const std::vector<struct frame_range_t> & ranges, size_t i) {
+	for (size_t r = 0; r < ranges.size(); ++r)
+		if (i + 1 >= ranges[r].first && i + 1 <= ranges[r].last)
+			return true;
+	return false;
+}
+
+/**
+ * @brief  Write composited screen as BMP
+ *
+ * @param factor BMP is downscaled by factor, 1 for full size
+ */
+static bool write_screen(size_t & size, Compositor & screen, unsigned factor,
+		struct gif2bmp_ctx_t * ctx, FILE * f, struct stage_time_t * write_time) {
+	if (factor > 1)
+		return generate_bmp_bgr_scaled(size, screen.width(), screen.height(), screen.bgr(), factor,
+				ctx->row, ctx->sums, f, write_time);
+
+	return generate_bmp_bgr(size, screen.width(), screen.height(), screen.bgr(), ctx->row, f,
+			write_time);
+}
+
+/**
+ * @brief  Write composited screen to output
+ *
+ * @param written frames written so far by hash of their screen, frame
+ * identical to an earlier one is linked to it; NULL to write every frame
+ */
+static bool write_frame(struct gif2bmp_t * status, Compositor & screen, size_t i,
+		FILE * out_file, struct gif2bmp_ctx_t * ctx, const struct gif2bmp_out_t * out,
+		const struct gif2bmp_view_t & view, std::unordered_map<uint64_t, size_t> * written) {
+	TRACE_SPAN("generate_bmp", i);
+	struct stage_time_t * write_time = status ? &status->stages[kStageWrite] : NULL;
+	const unsigned factor = view.factor;
+	const size_t width = view.width;
+	const size_t height = view.height;
+	size_t size = 0;
+	bool ok;
+
+	if (out_file) {
+		ok = write_screen(size, screen, factor, ctx, out_file, write_time);
+	} else {
+		if (written) {
+			uint64_t seed = ((uint64_t) screen.width() << 32) | screen.height();
+			uint64_t key = xxh64(screen.bgr(), 3 * screen.width() * screen.height(), seed);
+			std::pair<std::unordered_map<uint64_t, size_t>::iterator, bool> it =
+					written->insert(std::make_pair(key, i));
+			if (! it.second)
+				return gif2bmp_link_image(i, it.first->second, bmp_file_size(width, height),
+						out, status);
+		}
+
+		FILE * f = gif2bmp_open_image(i, width, height, out);
+		if (! f)
+			return false;
+		ok = write_screen(size, screen, factor, ctx, f, write_time);
+		ok = gif2bmp_close_image(f, out) && ok;
+	}
+
+	if (ok && status)
+		status->bmp_size += size;
+	return ok;
+}
+
+/**
+ * @brief  Parse, decode and draw one image
+ *
+ * @param view part of screen to decode, NULL for whole image
+ */
+static bool draw_frame(struct gif2bmp_t * status, FILE * f, uint64_t base,
+		const struct gif_frame_info_t & frame, Compositor & screen, struct gif2bmp_ctx_t * ctx,
+		const struct region_t * view) {
+	Gif & gif = ctx->gif;
+	GifImgData * img;
+
+	{
+		StageTimer timer(status ? &status->stages[kStageParse] : NULL);
+		img = gif.parse_image_at(f, base + frame.offset);
+	}
+	if (! img)
+		return false;
+
+	std::vector<Gif::color_item_t> * color_table;
+	if (img->has_local_color_table()) {
+		color_table = &img->local_color_table;
+	} else if (gif.has_global_color_table()) {
+		color_table = &gif.global_color_table;
+	} else {
+		err() << "No global nor local color table!\n";
+		return false;
+	}
+
+	const struct region_t whole = { 0, 0, img->image_desc.width, img->image_desc.height };
+	const struct region_t region = view ? gif2bmp_image_region(img, *view) : whole;
+	size_t pixels = region.width * region.height;
+	size_t count;
+	if (ctx->indexes.size() < pixels)
+		ctx->indexes.resize(pixels);
+
+	{
+		TRACE_SPAN("lzw");
+		StageTimer timer(status ? &status->stages[kStageDecode] : NULL);
+		bool decoded = view ? ctx->lzw.decode_region(img, region, ctx->indexes.data(), count)
+				: ctx->lzw.decode(img, ctx->indexes.data(), count);
+		if (! decoded)
+			return false;
+	}
+	if (status)
+		gif2bmp_count_image(status, ctx->lzw.stats(), count);
+
+	StageTimer timer(status ? &status->stages[kStageConvert] : NULL);
+	screen.draw(img, frame, ctx->indexes.data(), count, region, color_table);
+	gif.release_images();
+	return true;
+}
+
+/**
+ * @brief  Convert selected frames of animation, composited on logical screen
+ *
+ * Only images from keyframe of the first selected frame on are read and
+ * decoded, data of other images are skipped.
+ *
+ * @param status output status, may be NULL
+ * @param in_file input file (GIF)
+ * @param out_file output file (BMP) for single selected frame, when NULL every
+ * selected frame N is written to file N.bmp (0001.bmp...)
+ * @param ranges selected frames
+ * @param ctx decoder working storage to reuse, when NULL a temporary one is used
+ * @param index_path frame index of input, used when it matches input and
+ * (re)written otherwise, ignored when NULL or input is not a regular file
+ * @param out destination of frames when out_file is NULL, may be NULL
+ *
+ * @return  0 on success
+ */
+int gif2bmp_frames(struct gif2bmp_t * status, FILE * in_file, FILE * out_file,
+		const std::vector<struct frame_range_t> & ranges, struct gif2bmp_ctx_t * ctx,
+		const char * index_path, const struct gif2bmp_out_t * out) {
+	struct gif2bmp_ctx_t * local_ctx = NULL;
+	struct gif_info_t info;
+	std::vector<char> data;
+	FILE * f = in_file;
+	FILE * mem_file = NULL;
+	uint64_t allocs = alloc_count();
+	long base = 0;
+	int res = 1;
+
+	if (status)
+		gif2bmp_reset_stats(status);
+
+	/*
+	 * Images are read by offsets, input which cannot seek is read whole
+	 */
+	bool probed;
+	{
+		TRACE_SPAN("probe");
+		StageTimer timer(status ? &status->stages[kStageParse] : NULL);
+		struct stat st;
+		if (fstat(fileno(in_file), &st) == 0 && S_ISREG(st.st_mode)) {
+			base = ftell(in_file);
+			if (base != 0)
+				index_path = NULL;
+			if (index_path && index_load(index_path, in_file, &info)) {
+				probed = true;
+			} else {
+				probed = base >= 0 && gif_probe_file(in_file, &info);
+				if (probed && index_path)
+					index_save(index_path, in_file, &info);
+			}
+		} else if (read_all(in_file, data) && ! data.empty()
+				&& (mem_file = fmemopen(&data[0], data.size(), "rb")) != NULL) {
+			f = mem_file;
+			probed = gif_probe((const uint8_t *) data.data(), data.size(), &info);
+		} else {
+			err() << "Failed to read input!\n";
+			probed = false;
+		}
+	}
+
+	std::vector<size_t> wanted;
+	for (size_t i = 0; probed && i < info.frames.size(); ++i)
+		if (selected(ranges, i))
+			wanted.push_back(i);
+
+	if (! probed) {
+		err() << "Parse FAILED due to fatal errors!\n";
+	} else if (wanted.empty()) {
+		err() << "No frame selected, GIF has " << std::dec << info.frames.size() << " frames!\n";
+	} else if (out_file && wanted.size() > 1) {
+		err() << "Several frames selected, use -e to write them to separate files!\n";
+	} else {
+		if (! ctx)
+			ctx = local_ctx = new struct gif2bmp_ctx_t;
+		ctx->gif.reset();
+
+		Compositor screen;
+		struct gif2bmp_view_t view;
+		MemoryReservation memory;
+		std::unordered_map<uint64_t, size_t> written;
+		bool ok = fseek(f, base, SEEK_SET) == 0 && ctx->gif.parse_header(f);
+		size_t next = 0;
+		size_t i = info.frames.size();
+
+		/*
+		 * All images are known from probe, check them before screen is
+		 * allocated
+		 */
+		uint64_t pixels = (uint64_t) info.width * info.height;
+		uint64_t decoded = 0;
+		for (size_t k = 0; ok && k < info.frames.size(); ++k) {
+			const struct gif_frame_info_t & fr = info.frames[k];
+			decoded += (uint64_t) fr.width * fr.height;
+			pixels = std::max(pixels, (uint64_t) fr.width * fr.height);
+			ok = limits_check_image(k, fr.width, fr.height, decoded);
+		}
+
+		if (ok)
+			ok = memory.ensure(kBytesPerPixel * pixels) && gif2bmp_view(&ctx->gif, out, view);
+		if (ok)
+			screen.start(&ctx->gif, view.region);
+
+		/*
+		 * Skip images up to keyframe of next selected frame, unless
+		 * screen composited so far is needed
+		 */
+		while (ok && next < wanted.size()) {
+			size_t k = info.frames[wanted[next]].keyframe;
+			if (i >= info.frames.size() || k > i) {
+				i = k;
+				screen.clear();
+			}
+
+			/*
+			 * images outside of crop region change nothing, not even by
+			 * their disposal
+			 */
+			TRACE_SPAN("frame", i);
+			const struct gif_frame_info_t & fr = info.frames[i];
+			bool hidden = view.crop && (fr.left >= view.region.left + view.region.width
+					|| fr.top >= view.region.top + view.region.height
+					|| (size_t) fr.left + fr.width <= view.region.left
+					|| (size_t) fr.top + fr.height <= view.region.top);
+			if (! hidden)
+				ok = draw_frame(status, f, base, fr, screen, ctx, view.crop ? &view.region : NULL);
+			if (ok && i == wanted[next]) {
+				ok = write_frame(status, screen, i, out_file, ctx, out, view,
+						out && out->dedup ? &written : NULL);
+				next++;
+			}
+			if (! hidden)
+				screen.dispose(fr);
+			i++;
+		}
+
+		ok = gif2bmp_finish_images(out, status) && ok;
+		if (ok)
+			res = 0;
+	}
+
+	if (mem_file)
+		fclose(mem_file);
+	delete local_ctx;
+
+	if (res == 0 && status) {
+		status->gif_size = info.size;
+		status->allocs = alloc_count() - allocs;
+	}
+
+	return res;
+}
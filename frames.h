@@ -0,0 +1,69 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 09:52:18 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef FRAMES_H_
+#define FRAMES_H_
+
+#include <inttypes.h>
+#include <cstdio>
+
+#include <vector>
+
+#include "gif.h"
+#include "probe.h"
+#include "gif2bmp.h"
+
+/**
+ * @brief  Inclusive range of frame numbers, counted from 1
+ */
+struct frame_range_t {
+	unsigned first;
+	unsigned last;
+};
+
+/**
+ * @brief  Composites images of animation on logical screen
+ *
+ * Screen is kept as BGR, ready to be written to BMP. Transparent pixels keep
+ * what is on the screen, disposal methods of Graphic Control Extension are
+ * applied by dispose(). Only part of screen in view is kept, everything drawn
+ * is clipped to it.
+ */
+class Compositor {
+public:
+	void start(Gif * gif, const struct region_t & view);
+	void clear();
+	void draw(GifImgData * img, const struct gif_frame_info_t & frame, const uint8_t * indexes,
+			size_t count, const struct region_t & region,
+			const std::vector<Gif::color_item_t> * color_table);
+	void dispose(const struct gif_frame_info_t & frame);
+
+	const uint8_t * bgr() const { return m_screen.data(); }
+	size_t width() const { return m_width; }
+	size_t height() const { return m_height; }
+
+private:
+	void fill(size_t left, size_t top, size_t width, size_t height);
+
+	std::vector<uint8_t> m_screen;
+	std::vector<uint8_t> m_saved;		///< Screen before image with kDisposalPrevious
+	struct region_t m_view;				///< Part of logical screen kept
+	size_t m_width;
+	size_t m_height;
+	uint8_t m_background[3];
+}; // class Compositor
+
+bool parse_frame_ranges(const char * spec, std::vector<struct frame_range_t> & ranges);
+
+int gif2bmp_frames(struct gif2bmp_t * status, FILE * in_file, FILE * out_file,
+		const std::vector<struct frame_range_t> & ranges, struct gif2bmp_ctx_t * ctx = NULL,
+		const char * index_path = NULL, const struct gif2bmp_out_t * out = NULL);
+
+#endif // FRAMES_H_
@@ -15,8 +15,13 @@
 #include <cstdlib>
 
 #include <functional>
+#include <algorithm>
+#include <string>
 
 #include "gif.h"
+#include "pool.h"
+#include "budget.h"
+#include "trace.h"
 #include "common.h"
 
 const size_t Gif::kHeaderSize							= (6+7);
@@ -33,20 +38,62 @@ const uint8_t Gif::kExtensionPlainText				= 0x01;
 
 const uint8_t Gif::kImageDescriptor					= 0x2c;
 
+/*
+ * Longest part of extension payload printed
+ */
+const size_t kMaxLogPayload							= 256;
+
 /**
  * @brief  Constructor
+ *
+ * @param pool pool to take image data buffers from, NULL to allocate them
  */
-Gif::Gif() {  }
+Gif::Gif(class BufferPool * pool) : m_pool(pool), m_concatenated(false) {
+	memset(&m_stats, 0, sizeof(m_stats));
+}
 
 /**
  * @brief  Destructor
  */
 Gif::~Gif() {
-	for (images_t::iterator it = m_images.begin(); it != m_images.end(); ++it) {
+	reset();
+
+	for (images_t::iterator it = m_free.begin(); it != m_free.end(); ++it) {
 		delete (*it);
 	}
 
-	m_images.clear();
+	m_free.clear();
+}
+
+/**
+ * @brief  Drop parsed GIF, storage is kept for parsing another one
+ */
+void Gif::reset() {
+	release_images();
+	global_color_table.clear();
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/**
+ * @brief  Get image structure, recycled one if possible
+ *
+ * @return  empty image, owned by this Gif
+ */
+class GifImgData * Gif::new_image() {
+	class GifImgData * img;
+
+	if (m_free.empty()) {
+		img = new class GifImgData;
+	} else {
+		img = m_free.back();
+		m_free.pop_back();
+	}
+
+	if (m_pool)
+		m_pool->get(img->compressed, 0);
+
+	m_images.push_back(img);
+	return img;
 }
 
 /**
@@ -129,6 +176,7 @@ void Gif::dbg_imgs() {
  * @return  true on success
  */
 bool Gif::parse_graphic_control_extension(FILE * f) {
+	TRACE_SPAN("graphic control extension");
 	int c;
 	int size;
 
@@ -149,6 +197,33 @@ bool Gif::parse_graphic_control_extension(FILE * f) {
 		return true;
 };
 
+/**
+ * @brief  Read data sub-blocks up to block terminator
+ *
+ * @param f file to read from
+ * @param text buffer for beginning of data, NULL to skip all data
+ * @param max size of text
+ * @param len number of bytes stored to text
+ *
+ * @return  block terminator or EOF
+ */
+static int read_sub_blocks(FILE * f, char * text, size_t max, size_t & len) {
+	char skip[255];
+	int size;
+
+	len = 0;
+	while ((size = fgetc(f)) != EOF && size != 0) {
+		size_t n = (text && len < max) ? std::min(max - len, (size_t) size) : 0;
+		if (n && fread(text + len, 1, n, f) != n)
+			return EOF;
+		len += n;
+		if ((size_t) size > n && fread(skip, 1, size - n, f) != size - n)
+			return EOF;
+	}
+
+	return size;
+}
+
 /**
  * @brief  Parse Application Extension
  *
@@ -157,35 +232,30 @@ bool Gif::parse_graphic_control_extension(FILE * f) {
  * @return  true on success
  */
 bool Gif::parse_application_extension(FILE * f) {
-	int c = 0;
-	size_t size;
-
-	std::ostream & out = (info() << "Application extension: ");
-	size = fgetc(f);
-	for (size_t i = 0; i < size && (c = fgetc(f)) != EOF; ++i) {
-		out << (char) c;
-	}
-	out << std::endl;
+	TRACE_SPAN("application extension");
+	char ident[255];
+	size_t len = 0;
+	size_t skipped;
+	int size;
 
 	/*
-	 * There can be multiple sub-blocks
+	 * Application identifier and authentication code, then data sub-blocks
 	 */
-	do {
-		size = fgetc(f);
-		for (size_t i = 0; i < size && c != EOF; ++i) {
-			c = fgetc(f);
-		}
-	} while (size != 0);
+	size = fgetc(f);
+	if (size != EOF && fread(ident, 1, size, f) == (size_t) size) {
+		len = size;
+		size = read_sub_blocks(f, NULL, 0, skipped);
+	} else {
+		size = EOF;
+	}
 
-	if (c == EOF) {
+	if (size == EOF) {
 		err() << "Premature end of application extension!\n";
 		return false;
-	} else if (c != kExtensionEndByte) {
-		err() << "End of application extension byte expected, got '0x"
-				<< std::hex << c << "'!\n";
-		return false;
-	} else
-		return true;
+	}
+
+	info() << "Application extension: " << std::string(ident, len) << std::endl;
+	return true;
 };
 
 /**
@@ -196,26 +266,17 @@ bool Gif::parse_application_extension(FILE * f) {
  * @return  true on success
  */
 bool Gif::parse_comment_extension(FILE * f) {
-	int c;
-	size_t size;
+	TRACE_SPAN("comment extension");
+	char text[kMaxLogPayload];
+	size_t len;
 
-	std::ostream & out = (info() << "Comment extension: ");
-	do {
-		size = c = fgetc(f);
-		for (size_t i = 0; i < size && c != EOF; ++i)
-			out << (char) (c = fgetc(f));
-	} while (c != kExtensionEndByte && c != EOF);
-	out << std::endl;
-
-	if (c == EOF) {
+	if (read_sub_blocks(f, g_log_level >= kLogInfo ? text : NULL, sizeof(text), len) == EOF) {
 		err() << "Premature end of comment extension!\n";
 		return false;
-	} else if (c != kExtensionEndByte) {
-		err() << "End of comment extension byte expected, got '0x"
-				<< std::hex << c << "'!\n";
-		return false;
-	} else
-		return true;
+	}
+
+	info() << "Comment extension: " << std::string(text, len) << std::endl;
+	return true;
 };
 
 /**
@@ -226,33 +287,26 @@ bool Gif::parse_comment_extension(FILE * f) {
  * @return  true on success
  */
 bool Gif::parse_plain_text_extension(FILE * f) {
-	UNUSED(f);
-	int c;
+	TRACE_SPAN("plain text extension");
+	char text[kMaxLogPayload];
+	char header[255];
+	size_t len = 0;
 	int size;
 
-	std::ostream & out = (info() << "Plain text extension: ");
-
-	// skip block
-	c = size = fgetc(f);
-	for (int i = 0; c != EOF && i < size; ++i)
-		c = fgetc(f);
-
-	do {
-		c = size = fgetc(f);
-		for (int i = 0; c != EOF && i < size; ++i)
-			out << (char) (c = fgetc(f));
-	} while (c != kExtensionEndByte && c != EOF);
-	out << std::endl;
+	// skip text grid and colors block
+	size = fgetc(f);
+	if (size != EOF && fread(header, 1, size, f) == (size_t) size)
+		size = read_sub_blocks(f, g_log_level >= kLogInfo ? text : NULL, sizeof(text), len);
+	else
+		size = EOF;
 
-	if (c == EOF) {
-		err() << "Premature end of comment extension!\n";
+	if (size == EOF) {
+		err() << "Premature end of plain text extension!\n";
 		return false;
-	} else if (c != kExtensionEndByte) {
-		err() << "End of plain text extension byte expected, got '0x"
-				<< std::hex << c << "'!\n";
-		return false;
-	} else
-		return true;
+	}
+
+	info() << "Plain text extension: " << std::string(text, len) << std::endl;
+	return true;
 };
 
 /**
@@ -263,10 +317,10 @@ bool Gif::parse_plain_text_extension(FILE * f) {
  * @return true on success
  */
 bool Gif::parse_image(FILE * f) {
+	TRACE_SPAN("image data", m_images.size());
 	struct image_descriptor_t image_desc;
 
-	class GifImgData * img = new class GifImgData;
-	m_images.push_back(img);
+	class GifImgData * img = new_image();
 
 	if (fread(&image_desc, kImageDescriptorSize, 1, f) != 1) {
 		err() << "Failed to read image descriptor!\n";
@@ -276,6 +330,13 @@ bool Gif::parse_image(FILE * f) {
 
 	img->image_desc = image_desc;
 
+	uint64_t pixels = (uint64_t) image_desc.width * image_desc.height;
+	if (! limits_check_image(m_stats.images, image_desc.width, image_desc.height,
+				m_stats.pixels + pixels))
+		return false;
+	m_stats.images++;
+	m_stats.pixels += pixels;
+
 	if (has_local_color_table(&image_desc)) {
 		struct color_item_t item;
 		for (size_t i = 0; i < get_local_table_size(&image_desc); ++i) {
@@ -293,11 +354,13 @@ bool Gif::parse_image(FILE * f) {
 	img->compressed.push_back(fgetc(f)); // lzw mincode size
 	do {
 		size = c = fgetc(f);
-		for (int i = 0; i < size && c != EOF; ++i) {
-			c = fgetc(f);
-			img->compressed.push_back(((unsigned) c) & 0xFF);
+		if (size > 0) {
+			m_stats.sub_blocks++;
+			size_t used = img->compressed.size();
+			img->compressed.resize(used + size);
+			if (fread(&img->compressed[used], 1, size, f) != (size_t) size)
+				c = EOF;
 		}
-		//img->compressed.push_back(c);
 	} while (size != 0 && c != EOF);
 
 
@@ -318,6 +381,25 @@ bool Gif::parse_image(FILE * f) {
  * @return true on success
  */
 bool Gif::parse(FILE * f) {
+	TRACE_SPAN("parse");
+	long start = ftell(f);
+	bool res = parse_stream(f);
+	long end = ftell(f);
+
+	if (start >= 0 && end >= start)
+		m_stats.bytes = end - start;
+
+	return res;
+}
+
+/**
+ * @brief  Parse header and global color table
+ *
+ * @param f file to parse from, positioned at start of GIF
+ *
+ * @return  true on success
+ */
+bool Gif::parse_header(FILE * f) {
 	/*
 	 * Read header
 	 */
@@ -331,6 +413,8 @@ bool Gif::parse(FILE * f) {
 	 */
 	if (! is_gif()) { err() << "Input file is not a GIF file!\n"; return false; }
 	if (! is_gif89a()) { err() << "Unsupported GIF version!\n"; return false; }
+	if (! limits_check_screen(m_header.screen_width, m_header.screen_height))
+		return false;
 	//if (! is_gif8bit()) { err() << "Not GIF 8bit!\n"; return false; }
 
 	/*
@@ -349,6 +433,103 @@ bool Gif::parse(FILE * f) {
 		//dbg_global_color();
 	}
 
+	return true;
+}
+
+/**
+ * @brief  Parse one image, skipping everything between
+ *
+ * Header has to be parsed by parse_header() already.
+ *
+ * @param f file to parse from
+ * @param offset offset of image separator in f
+ *
+ * @return  parsed image or NULL on error
+ */
+class GifImgData * Gif::parse_image_at(FILE * f, uint64_t offset) {
+	if (fseek(f, offset, SEEK_SET) != 0 || fgetc(f) != kImageDescriptor) {
+		err() << "Image expected at offset " << std::dec << offset << "!\n";
+		return NULL;
+	}
+
+	if (! parse_image(f))
+		return NULL;
+
+	return m_images.back();
+}
+
+/**
+ * @brief  Return parsed images for reuse, header and global color table are kept
+ */
+void Gif::release_images() {
+	for (images_t::iterator it = m_images.begin(); it != m_images.end(); ++it) {
+		if (m_pool)
+			m_pool->put((*it)->compressed);
+		(*it)->compressed.clear();
+		(*it)->decompressed.clear();
+		(*it)->local_color_table.clear();
+		m_free.push_back(*it);
+	}
+
+	m_images.clear();
+}
+
+/**
+ * @brief  Parse next image of GIF, previous images are released
+ *
+ * Only one image is kept at a time, so that memory does not grow with number
+ * of images. Header has to be parsed by parse_header() already.
+ *
+ * @param f file to parse from, positioned after previous image
+ * @param img parsed image, NULL when there are no more images
+ *
+ * @return  true on success
+ */
+bool Gif::next_image(FILE * f, class GifImgData ** img) {
+	bool image;
+
+	release_images();
+	if (! parse_blocks(f, image))
+		return false;
+
+	*img = image ? m_images.back() : NULL;
+	return true;
+}
+
+/**
+ * @brief Parse gif from a stream
+ *
+ * @param f file to parse from
+ *
+ * @return true on success
+ */
+bool Gif::parse_stream(FILE * f) {
+	bool image;
+
+	if (! parse_header(f))
+		return false;
+
+	do {
+		if (! parse_blocks(f, image))
+			return false;
+	} while (image);
+
+	//dbg_imgs();
+
+	return true;
+}
+
+/**
+ * @brief  Parse blocks up to and including next image
+ *
+ * @param f file to parse from
+ * @param image set when an image was parsed, unset at end of GIF
+ *
+ * @return  true on success
+ */
+bool Gif::parse_blocks(FILE * f, bool & image) {
+	image = false;
+
 	/*
 	 * Check start byte. Note than *_extension() functions access data without
 	 * entry byte!
@@ -379,6 +560,8 @@ bool Gif::parse(FILE * f) {
 						if (c == kImageDescriptor) {
 							if (! parse_image(f))
 								return false;
+							image = true;
+							return true;
 						} else if (c == kExtensionPlainText) {
 							if (! parse_plain_text_extension(f))
 								return false;
@@ -392,6 +575,11 @@ bool Gif::parse(FILE * f) {
 				}
 				break;
 			case kStopByte:
+				/*
+				 * next GIF starts right after trailer, it must not be read
+				 */
+				if (m_concatenated)
+					return true;
 				if (fgetc(f) != EOF) {
 					err() << "Stop byte is not last byte!\n";
 					return false;
@@ -405,8 +593,6 @@ bool Gif::parse(FILE * f) {
 		}
 	}
 
-	//dbg_imgs();
-
 	return true;
 }
 
@@ -19,6 +19,8 @@
 #include <vector>
 #include <list>
 
+class BufferPool;
+
 /*
  * Thanks to:
  * http://www.fileformat.info/format/gif/egff.htm
@@ -73,6 +75,17 @@ public:
 		uint8_t packed;				///< Image and Color Table Data Information
 	};
 
+	/**
+	 * @brief  Parser counters
+	 */
+	struct stats_t
+	{
+		uint64_t bytes;				///< Bytes of input parsed
+		uint64_t sub_blocks;			///< Image data sub-blocks
+		uint64_t images;				///< Image descriptors
+		uint64_t pixels;				///< Pixels of images by their descriptors
+	};
+
 	typedef std::vector<class GifImgData *> images_t;
 
 	images_t m_images;
@@ -86,6 +99,17 @@ public:
 	}
 
 	bool parse(FILE * f);
+	bool parse_header(FILE * f);
+	class GifImgData * parse_image_at(FILE * f, uint64_t offset);
+	bool next_image(FILE * f, class GifImgData ** img);
+	void release_images();
+	void reset();
+
+	/**
+	 * @brief  Whether GIFs follow each other in input, then nothing after
+	 * trailer is read
+	 */
+	void set_concatenated(bool concatenated) { m_concatenated = concatenated; }
 
 	bool has_global_color_table() { return getbit(m_header.packed, 7); }
 	bool is_gif8bit() { return ((m_header.packed >> 4) & 0x7) == 0x7; }
@@ -93,11 +117,20 @@ public:
 	size_t get_global_table_size() { return (1 << ((m_header.packed & 0x7) + 1)); }
 
 	struct header_t m_header;
+	struct stats_t m_stats;
 	std::vector<color_item_t> global_color_table;
 
-	Gif();
+	Gif(class BufferPool * pool = NULL);
 	~Gif();
 private:
+	Gif(const Gif &);
+	Gif & operator=(const Gif &);
+
+	class GifImgData * new_image();
+
+	images_t m_free;				///< Images kept for reuse by reset()
+	class BufferPool * m_pool;	///< Pool for image data, may be NULL
+	bool m_concatenated;			///< Another GIF may follow trailer
 
 	static bool getbit(uint64_t x, size_t n) { return (x >> (n)) & 1; }
 
@@ -131,6 +164,8 @@ private:
 	bool parse_plain_text_extension(FILE * f);
 
 	bool parse_image(FILE * f);
+	bool parse_blocks(FILE * f, bool & image);
+	bool parse_stream(FILE * f);
 
 	static const size_t kHeaderSize;
 	static const size_t kColorTableSize;
@@ -10,396 +10,723 @@
 
 #include <cstdio>
 #include <cstring>
-#include <stdexcept>
+#include <cerrno>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
 
 #include "gif2bmp.h"
 #include "common.h"
 #include "gif.h"
-
-const int kControlCode			= -1;
-const int kEndOfImage			= -2;
-const int kBMPHeaderSize		= 14;
-const int kBMPDIPHeaderSize	= 40;
+#include "bmp.h"
+#include "hash.h"
+#include "trace.h"
 
 const int kMaxFileNameSize		= 512;
+const size_t kHashChunkSize		= 256 << 10;
+
+const char * const kStageNames[kStageCount] = { "parse", "decode", "convert", "write" };
+const char * const kVerifyErrorNames[kVerifyErrorCount] = {
+	"parse", "noData", "minCodeSize", "badCode", "noEnd", "pixels"
+};
 
-#define MASK(X)			((1 << (X)) - 1)
-#define IS_CC(X)			(X[0] == kControlCode)
-#define IS_EOI(X)			(X[0] == kEndOfImage)
+/**
+ * @brief  Add counters of decoded image to status
+ *
+ * @param status status to update
+ * @param lzw counters of decoder
+ * @param count pixels decoded
+ */
+void gif2bmp_count_image(struct gif2bmp_t * status, const struct lzw_stats_t & lzw, size_t count) {
+	status->frames++;
+	status->lzw.codes += lzw.codes;
+	status->lzw.clears += lzw.clears;
+	for (size_t i = 0; i < sizeof(lzw.widths) / sizeof(lzw.widths[0]); ++i)
+		status->lzw.widths[i] += lzw.widths[i];
+	if (status->frame_pixels)
+		status->frame_pixels->push_back(count);
+}
+
+/**
+ * @brief  Set up color table of image
+ *
+ * @return  false when there is no color table
+ */
+static bool select_color_table(GifImgData * img, Gif * gif, struct gif2bmp_frame_t & frame) {
+	if (img->has_local_color_table()) {
+		frame.color_table = &img->local_color_table;
+	} else if (gif->has_global_color_table()) {
+		frame.color_table = &gif->global_color_table;
+	} else {
+		err() << "No global nor local color table!\n";
+		return false;
+	}
 
+	return true;
+}
 
 /**
- * @brief  Generate BMP image
+ * @brief  Decode LZW compression of image to indexes
  *
- * @param sizeo output size of BMP image
- * @param gif Gif from which BMP should be generated
- * @param indexes Decoded indexes to color table
- * @param color_table used color table
- * @param out_file output file to write to
+ * @param img image data to be decompressed
+ * @param ctx decoder working storage
+ * @param status counters to update, may be NULL
+ * @param frame decoded image, index and color table are not set
+ * @param view part of screen to decode, NULL for whole image
  *
- * @return  true on success
+ * @return   true on success
  */
-static inline
-bool generate_bmp(size_t & sizeo, const Gif * gif, const std::vector<uint8_t> * indexes, const std::vector<Gif::color_item_t> * color_table, FILE * out_file) {
-	/*
-	 * Header
-	 */
-	fwrite("BM", 1, 2, out_file);
-	uint32_t size = kBMPHeaderSize + kBMPDIPHeaderSize + indexes->size() * 3 + 4;
-	sizeo = size;
-	fwrite(&size, 4, 1, out_file);
-	uint16_t tmp16 = 0;
-	uint32_t tmp32 = 0;
-	fwrite(&tmp32, 4, 1, out_file);
-	tmp32 = kBMPHeaderSize + kBMPDIPHeaderSize;
-	fwrite(&tmp32, 4, 1, out_file);
+static bool decode_indexes(GifImgData * img, struct gif2bmp_ctx_t * ctx,
+		struct gif2bmp_t * status, struct gif2bmp_frame_t & frame, const struct region_t * view) {
+	const struct region_t whole = { 0, 0, img->image_desc.width, img->image_desc.height };
+	frame.region = view ? gif2bmp_image_region(img, *view) : whole;
+
 	/*
-	 * DIP Header
+	 * decode to plane of indexes, the plane is only grown so that it does not
+	 * have to be cleared again for every image
 	 */
-	tmp32 = kBMPDIPHeaderSize;
-	fwrite(&tmp32, 4, 1, out_file);
-	tmp32 = gif->m_header.screen_width;
-	fwrite(&tmp32, 4, 1, out_file);
-	tmp32 = gif->m_header.screen_height;
-	fwrite(&tmp32, 4, 1, out_file);
-	tmp16 = 1; // plane
-	fwrite(&tmp16, 2, 1, out_file);
-	tmp16 = 24;
-	fwrite(&tmp16, 2, 1, out_file);
-	tmp32 = 0;
-	fwrite(&tmp32, 4, 1, out_file);
-	tmp16 = (indexes->size() * 3); // raw size
-	{
-		// padding to 4bytes
-		size_t w = (3 * gif->m_header.screen_width) & 0x2;
-		for (size_t i = 0; i < 4 - w; ++i) {
-			tmp16++;
-			//uint8_t p = 0;
-			//fwrite(&p, 1, 1, out_file);
-		}
+	size_t pixels = frame.region.width * frame.region.height;
+	if (ctx->indexes.size() < pixels)
+		ctx->indexes.resize(pixels);
 
+	{
+		TRACE_SPAN("lzw");
+		StageTimer timer(status ? &status->stages[kStageDecode] : NULL);
+		bool ok = view ? ctx->lzw.decode_region(img, frame.region, ctx->indexes.data(), frame.count)
+				: ctx->lzw.decode(img, ctx->indexes.data(), frame.count);
+		if (! ok)
+			return false;
 	}
-	fwrite(&tmp16, 4, 1, out_file);
-	tmp32 = 2835; // print resolution
-	fwrite(&tmp32, 4, 1, out_file);
-	tmp32 = 2835; // print resolution
-	fwrite(&tmp32, 4, 1, out_file);
-	tmp32 = 0; // number of colors in palette
-	fwrite(&tmp32, 4, 1, out_file);
-	tmp32 = 0; // number of colors in palette
-	fwrite(&tmp32, 4, 1, out_file);
-
-	for (size_t i = 1; i <= gif->m_header.screen_height; ++i) {
-		for (size_t j = 0; j < gif->m_header.screen_width; ++j) {
-			try {
-			fwrite(&color_table->at(indexes->at((gif->m_header.screen_height - i)
-								* gif->m_header.screen_width + j)).data.blue, 1, 1, out_file);
-			fwrite(&color_table->at(indexes->at((gif->m_header.screen_height - i)
-								* gif->m_header.screen_width + j)).data.green, 1, 1, out_file);
-			fwrite(&color_table->at(indexes->at((gif->m_header.screen_height - i)
-								* gif->m_header.screen_width + j)).data.red, 1, 1, out_file);
-			} catch (std::out_of_range e) {
-				UNUSED(e);
-				warn() << "Wrong index to color table, using black color!\n";
-				fwrite("\x00\x00\x00\x00\x00\x00\x00\x00\x00", 1, 9, out_file);
-			}
-		}
 
-		size_t w = (3 * gif->m_header.screen_width) & 0x3;
-		for (size_t j = 0; j < 4 - w && w != 0; ++j) {
-			uint8_t p = 0x00;
-			fwrite(&p, 1, 1, out_file);
-		}
-	}
+	if (status)
+		gif2bmp_count_image(status, ctx->lzw.stats(), frame.count);
 
+	frame.img = img;
+	frame.indexes = ctx->indexes.data();
 	return true;
 }
 
 /**
- * @brief  Get nearest power of two from x
+ * @brief  Decode image to indexes, with its color table
  *
- * @param x num to gen pow2 from
- *
- * @return   power of two
+ * @return   true on success
  */
-static inline
-int pow2up (int x) {
-	if (x < 0) return 0;
-	--x;
-	x |= x >> 1;
-	x |= x >> 2;
-	x |= x >> 4;
-	x |= x >> 8;
-	x |= x >> 16;
-	return x+1;
+static bool decode_image(GifImgData * img, Gif * gif, struct gif2bmp_ctx_t * ctx,
+		struct gif2bmp_t * status, struct gif2bmp_frame_t & frame, const struct region_t * view) {
+	return select_color_table(img, gif, frame) && decode_indexes(img, ctx, status, frame, view);
 }
 
 /**
- * @brief  Get nearest log2 from index
+ * @brief  Write decoded image as BMP
  *
- * @param index num to log2 from
+ * @param size size of output image
+ * @param frame decoded image
+ * @param gif image which data were decompressed
+ * @param out_file output file
+ * @param ctx decoder working storage
+ * @param status counters to update, may be NULL
+ * @param view part of screen written and its size
  *
- * @return   log2 of num
+ * @return   true on success
  */
-static inline
-int log2up(int index) {
-	int log = 0;
-	int idx_bac = index;
-	while (index >>= 1) ++log;
-	if ((1 << log) <= idx_bac) ++log;
-	return log;
+static bool write_bmp(size_t & size, const struct gif2bmp_frame_t & frame, Gif * gif,
+		FILE * out_file, struct gif2bmp_ctx_t * ctx, struct gif2bmp_t * status,
+		const struct gif2bmp_view_t & view) {
+	TRACE_SPAN("generate_bmp");
+	struct stage_time_t * convert_time = status ? &status->stages[kStageConvert] : NULL;
+	struct stage_time_t * write_time = status ? &status->stages[kStageWrite] : NULL;
+
+	if (view.crop) {
+		const Gif::image_descriptor_t & desc = frame.img->image_desc;
+		struct region_t place = {
+			desc.left + frame.region.left - view.region.left,
+			desc.top + frame.region.top - view.region.top,
+			frame.region.width, frame.region.height
+		};
+		return generate_bmp_region(size, view.region.width, view.region.height, frame.indexes,
+				frame.count, place, frame.color_table, view.factor, ctx->row, ctx->sums, out_file,
+				convert_time, write_time);
+	}
+
+	if (view.factor > 1)
+		return generate_bmp_scaled(size, gif, frame.indexes, frame.count, frame.color_table,
+				view.factor, ctx->row, ctx->sums, out_file, convert_time, write_time);
+
+	return generate_bmp(size, gif, frame.indexes, frame.count, frame.color_table, ctx->row, out_file,
+			convert_time, write_time);
 }
 
 /**
- * @brief  Get index from byte stream
- *
- * @param idx output index
- * @param start start index
- * @param idx_size size of the index in (num of bits)
- * @param byte1 first byte use
- * @param byte2 second byte to use
- * @param byte3 third byte to use
- *
- * @return number of bytes that can be discarded (1 => byte1, 2=> byte2)
- */
-static inline
-int getIdx(size_t & idx, size_t & start, size_t idx_size,
-		uint8_t byte1, uint8_t byte2, uint8_t byte3 = 0) {
-	assert(start <= 7);
-
-	if (start + idx_size > 8 && start + idx_size > 15) {
-		idx = ((byte1 >> start) & MASK(8 - start));				// lower part from byte1
-		idx = idx | (byte2  << (8 - start));
-		idx = idx | ((byte3 & MASK(idx_size - 8 - (8 - start))) << (8 + (8 - start)));
-		start = start + idx_size;
-		start = start & 0x7;
-		return 2;
-	} else if (start + idx_size > 8 && start + idx_size <= 16) {
-		idx = ((byte1 >> start) & MASK(8 - start));				// lower part from byte1
-		if (idx_size - (8 - start) > 0) {
-			// upper part from byte2
-			idx = idx | ((byte2 & MASK(idx_size - (8 - start))) << (8 - start));
-		}
-		start = start + idx_size;
-		if (start > 15) {
-			start = start & 0x7;
-			return 2;
-		} else {
-			start = start & 0x7;
-			return 1;
+ * @brief  Part of screen written to BMP and its size
+ *
+ * @param gif GIF with parsed header
+ * @param out options of output, may be NULL
+ * @param view cropped screen and downscaling
+ *
+ * @return  false when crop region is outside of screen
+ */
+bool gif2bmp_view(const Gif * gif, const struct gif2bmp_out_t * out, struct gif2bmp_view_t & view) {
+	const size_t width = gif->m_header.screen_width;
+	const size_t height = gif->m_header.screen_height;
+	const struct region_t * crop = out ? out->crop : NULL;
+
+	view.region.left = view.region.top = 0;
+	view.region.width = width;
+	view.region.height = height;
+	view.crop = crop != NULL;
+
+	if (crop) {
+		if (crop->left >= width || crop->top >= height) {
+			err() << "Crop region is outside of " << std::dec << width << "x" << height
+					<< " screen!\n";
+			return false;
 		}
-		return 1;	// bytes were swapped, new byte 2 expected
-	} else if (start + idx_size <= 8) {
-		idx = ((byte1 >> start) & MASK(idx_size));
-		start += idx_size;
-		if (start > 7) {
-			start = start & 0x7;
-			return 1;	// bytes were swapped, new byte 2 expected
-		} else
-			return 0;
-	} else {
-		assert(0);
-		return 1;
+		view.region.left = crop->left;
+		view.region.top = crop->top;
+		view.region.width = std::min(crop->width, width - crop->left);
+		view.region.height = std::min(crop->height, height - crop->top);
 	}
+
+	view.factor = out ? bmp_scale_factor(view.region.width, view.region.height,
+			out->scale, out->max_dim) : 1;
+	view.width = bmp_scaled(view.region.width, view.factor);
+	view.height = bmp_scaled(view.region.height, view.factor);
+	return true;
 }
 
 /**
- * @brief  Add indexes to dictionary
+ * @brief  Part of image which is visible in part of screen
  *
- * @param dic dictionary to be used
- * @param add vector to be added to dic
- * @param size number of base dic size
+ * @param img image with descriptor
+ * @param view part of screen
+ *
+ * @return  region in image coordinates, empty when image is outside of view
  */
-static inline
-void add_to_dic(std::vector< std::vector<int> > & dic, const std::vector<int> & add, size_t size) {
-	for (size_t i = 0; i < size; i++) {
-		if (dic[i].size() == add.size()) {
-			for (size_t j = 0; j < dic[i].size(); ++j) {
-				if (dic[i][j] == add[j] && j == dic[i].size() - 1) {
-					return;
-				} else if (dic[i][j] != add[j])
-					break;
-			}
-		}
+struct region_t gif2bmp_image_region(const GifImgData * img, const struct region_t & view) {
+	const Gif::image_descriptor_t & desc = img->image_desc;
+	size_t left = std::max((size_t) desc.left, view.left);
+	size_t top = std::max((size_t) desc.top, view.top);
+	size_t right = std::min((size_t) desc.left + desc.width, view.left + view.width);
+	size_t bottom = std::min((size_t) desc.top + desc.height, view.top + view.height);
+	struct region_t region = { 0, 0, 0, 0 };
+
+	if (left < right && top < bottom) {
+		region.left = left - desc.left;
+		region.top = top - desc.top;
+		region.width = right - left;
+		region.height = bottom - top;
 	}
-	dic.push_back(add);
+
+	return region;
 }
 
 /**
- * @brief  Decode LZW compression
+ * @brief  Estimate of memory needed to convert image
  *
- * @param size size of output image
- * @param img image data to be decompressed
- * @param gif image which data are decompressed
- * @param out_file output file
+ * @param header header of GIF
+ * @param img image to convert, NULL for screen only
  *
- * @return   true on success
+ * @return  bytes for screen or image, whichever is bigger
  */
-static inline
-bool decode_lzw(size_t & size, GifImgData * img, Gif * gif, FILE * out_file) {
+static uint64_t memory_needed(const Gif::header_t & header, const GifImgData * img) {
+	uint64_t pixels = (uint64_t) header.screen_width * header.screen_height;
+
+	if (img)
+		pixels = std::max(pixels, (uint64_t) img->image_desc.width * img->image_desc.height);
+
+	return kBytesPerPixel * pixels;
+}
+
+/**
+ * @brief  Constructor
+ *
+ * @param f file to read GIF from, positioned at its start
+ * @param ctx decoder working storage
+ * @param status counters to update, may be NULL
+ */
+FrameReader::FrameReader(FILE * f, struct gif2bmp_ctx_t * ctx, struct gif2bmp_t * status)
+		: m_file(f), m_ctx(ctx), m_status(status), m_index(0), m_start(0), m_failed(false) {
+}
+
+/**
+ * @brief  Parse header and global color table, previous GIF in ctx is dropped
+ *
+ * @return  true on success
+ */
+bool FrameReader::start() {
+	m_memory.release();
+
+	{
+		StageTimer timer(m_status ? &m_status->stages[kStageParse] : NULL);
+		m_ctx->gif.reset();
+		m_index = 0;
+		m_start = ftell(m_file);
+		m_failed = ! m_ctx->gif.parse_header(m_file);
+	}
+
 	/*
-	 * set up color table to use
+	 * Wait for memory before anything is decoded
 	 */
-	std::vector<Gif::color_item_t> * color_table;
-	if (img->has_local_color_table()) {
-		color_table = &img->local_color_table;
-	} else if (gif->has_global_color_table()) {
-		color_table = &gif->global_color_table;
-	} else {
-		err() << "No global nor local color table!\n";
+	if (! m_failed) {
+		m_failed = ! m_memory.ensure(memory_needed(m_ctx->gif.m_header, NULL));
+	}
+
+	return ! m_failed;
+}
+
+/**
+ * @brief  Read next image, it is not decoded yet
+ *
+ * @param frame image with color table, valid until next call
+ *
+ * @return  false at end of GIF or on error, see failed()
+ */
+bool FrameReader::read(struct gif2bmp_frame_t & frame) {
+	GifImgData * img = NULL;
+	bool ok;
+
+	if (m_failed)
 		return false;
+
+	{
+		StageTimer timer(m_status ? &m_status->stages[kStageParse] : NULL);
+		ok = m_ctx->gif.next_image(m_file, &img);
 	}
 
-	/*
-	 * init dic
-	 */
-	std::vector< std::vector<int> > dic;
-	for (size_t i = 0; i < color_table->size(); ++i) {
-		dic.push_back(std::vector<int>());
-		dic[i].push_back(i);
+	if (ok && img) {
+		frame.index = m_index++;
+		frame.img = img;
+		frame.indexes = NULL;
+		frame.count = 0;
+		if (select_color_table(img, &m_ctx->gif, frame)
+				&& m_memory.ensure(memory_needed(m_ctx->gif.m_header, img)))
+			return true;
+		ok = false;
 	}
 
-	/*
-	 * add Control code and End of image to dic
-	 */
-	dic.push_back(std::vector<int>());
-	dic[dic.size() - 1].push_back(kControlCode);
-	dic.push_back(std::vector<int>());
-	dic[dic.size() - 1].push_back(kEndOfImage);
+	m_failed = ! ok;
+	stop();
+	return false;
+}
 
-	/*
-	 * run lzw decoder
-	 */
-	std::vector<int> phrase;
-	std::vector<uint8_t> indexes;
-	std::vector<int> tmp;
-	size_t idx = 0;
-	size_t j = 1; // skip lzw min code size
-	size_t start = 0;
-	uint8_t byte1 = img->compressed[j++];
-	uint8_t byte2 = img->compressed[j++];
-	uint8_t byte3 = img->compressed[j++];
-	unsigned idx_size = img->compressed[0]; // lzw min code size
-	size_t original_size = dic.size();
-	idx_size++; // Clear Code and End Of Image has to be indexed too
-	int res;
-	for(;;) {
-		idx_size = log2up(dic.size());
-		if (idx_size == 13)
-			idx_size = 12;
-
-		if ((res = getIdx(idx, start, idx_size, byte1, byte2, byte3))) {
-			if (res == 1) {
-				byte1 = byte2;
-				byte2 = byte3;
-				if (j < img->compressed.size())
-					byte3 = img->compressed[j++];
-				else
-					byte3 = 0;
-			} else if (res == 2) {
-				byte1 = byte3;
-				if (j < img->compressed.size())
-					byte2 = img->compressed[j++];
-				else
-					byte2 = 0;
-				if (j < img->compressed.size())
-					byte3 = img->compressed[j++];
-				else
-					byte3 = 0;
-			}
-		}
+/**
+ * @brief  Decode image returned by read()
+ *
+ * @param frame image to decode
+ * @param view part of screen to decode, NULL for whole image
+ *
+ * @return  true on success
+ */
+bool FrameReader::decode(struct gif2bmp_frame_t & frame, const struct region_t * view) {
+	if (decode_indexes(frame.img, m_ctx, m_status, frame, view))
+		return true;
 
-		//dbg() << "Index:\t" << std::dec << (unsigned) idx << std::endl;
-		//dbg() << "Start:\t" << std::dec << (unsigned)start << std::endl;
-		//dbg() << "idx_size:\t" << std::dec << (unsigned)idx_size << std::endl;
-		//dbg() << "byte1:\t0x" << std::hex << (unsigned)byte1 << std::endl;
-		//dbg() << "byte2:\t0x" << std::hex << (unsigned)byte2 << std::endl;
-		//dbg() << "byte3:\t0x" << std::hex << (unsigned)byte3 << std::endl;
-		//dbg() << "shift count:\t" << std::dec << (unsigned)res << std::endl;
-		//dbg() << "dic size:\t" << std::dec << dic.size() << std::endl;
-		//dbg() << "j\t\t\t" << std::dec << j << std::endl;
-
-		if (idx < dic.size()) {
-			if (IS_CC(dic[idx])) { dic.resize(original_size); tmp.clear(); continue; }
-			if (IS_EOI(dic[idx])) { dbg() << "EOI: " << j << " =?= " << img->compressed.size() << std::endl; break; }
-
-			phrase = dic[idx];
-
-			for (size_t i = 0; i < phrase.size(); ++i)
-				indexes.push_back(phrase[i]);
-
-			{ // add to dic
-				std::vector<int> v = tmp;
-				v.push_back(phrase[0]);
-				add_to_dic(dic, v, original_size);
-			}
-		} else {
-			if (idx != dic.size()) {
-				warn() << "Bad index byte to dictionary. Image could be demaged!\n";
-			}
+	m_failed = true;
+	stop();
+	return false;
+}
 
-			phrase = tmp;
-			phrase.push_back(tmp[0]);
+/**
+ * @brief  Read and decode next image
+ *
+ * @param frame decoded image, valid until next call
+ *
+ * @return  false at end of GIF or on error, see failed()
+ */
+bool FrameReader::next(struct gif2bmp_frame_t & frame) {
+	return read(frame) && decode(frame);
+}
 
-			for (size_t i = 0; i < phrase.size(); ++i)
-				indexes.push_back(phrase[i]);
+/**
+ * @brief  Store parser counters when reading stops
+ */
+void FrameReader::stop() {
+	if (! m_status)
+		return;
 
-			add_to_dic(dic, phrase, original_size);
-		}
+	long end = ftell(m_file);
+	m_status->parse = m_ctx->gif.m_stats;
+	if (m_start >= 0 && end >= m_start)
+		m_status->parse.bytes = end - m_start;
+}
+
+/**
+ * @brief  Start output of extracted image, file NNNN.bmp or entry of archive
+ *
+ * @param i image index counted from 0
+ * @param width width of BMP
+ * @param height height of BMP
+ * @param out destination of images, NULL for plain files
+ *
+ * @return  output to write BMP to, NULL on error
+ */
+FILE * gif2bmp_open_image(size_t i, size_t width, size_t height, const struct gif2bmp_out_t * out) {
+	char filename[kMaxFileNameSize];
+
+	snprintf(filename, sizeof(filename), "%04zu.bmp", i + 1);
+	if (out && out->tar)
+		return out->tar->begin(filename, bmp_file_size(width, height)) ? out->tar->file() : NULL;
+	if (out && out->writer)
+		return out->writer->open(filename, bmp_file_size(width, height));
+
+	FILE * f = fopen(filename, "wb");
+	if (! f)
+		err() << "Failed to create file '" << filename << "'\n";
+	return f;
+}
 
-		tmp = phrase;
+/**
+ * @brief  Finish output of extracted image
+ *
+ * @param f output returned by gif2bmp_open_image()
+ * @param out destination of images, NULL for plain files
+ *
+ * @return  true on success
+ */
+bool gif2bmp_close_image(FILE * f, const struct gif2bmp_out_t * out) {
+	if (out && out->tar)
+		return out->tar->end();
+	if (out && out->writer)
+		return out->writer->close(f);
+
+	return fclose(f) == 0;
+}
+
+/**
+ * @brief  Wait for extracted images written in background
+ *
+ * @param out destination of images, NULL for plain files
+ * @param status status to add time spent waiting to, may be NULL
+ *
+ * @return  true when all images were written
+ */
+bool gif2bmp_finish_images(const struct gif2bmp_out_t * out, struct gif2bmp_t * status) {
+	if (! out || ! out->writer)
+		return true;
+
+	StageTimer timer(status ? &status->stages[kStageWrite] : NULL);
+	return out->writer->finish();
+}
+
+/**
+ * @brief  Write extracted image as link to identical image written earlier
+ *
+ * @param i image index counted from 0
+ * @param target index of identical image
+ * @param size size of BMP, counted as deduplicated
+ * @param out destination of images, NULL for plain files
+ * @param status status to count image to, may be NULL
+ *
+ * @return  true on success
+ */
+bool gif2bmp_link_image(size_t i, size_t target, uint64_t size, const struct gif2bmp_out_t * out,
+		struct gif2bmp_t * status) {
+	char filename[kMaxFileNameSize];
+	char target_name[kMaxFileNameSize];
+	bool ok;
+
+	snprintf(filename, sizeof(filename), "%04zu.bmp", i + 1);
+	snprintf(target_name, sizeof(target_name), "%04zu.bmp", target + 1);
+
+	if (out && out->tar)
+		ok = out->tar->link(filename, target_name);
+	else if (out && out->writer)
+		ok = out->writer->link(target_name, filename);
+	else
+		ok = link_file(target_name, filename);
+
+	if (ok && status) {
+		status->dedup_frames++;
+		status->dedup_bytes += size;
 	}
+	return ok;
+}
+
+/**
+ * @brief  Hash of everything raw BMP of image depends on, available before
+ * the image is decoded
+ *
+ * @param frame image read by FrameReader::read()
+ *
+ * @return  XXH64 of descriptor, color table and compressed data
+ */
+uint64_t gif2bmp_image_key(const struct gif2bmp_frame_t & frame) {
+	const Gif::image_descriptor_t & desc = frame.img->image_desc;
+	const uint16_t fields[] = { desc.width, desc.height, desc.packed };
+	uint8_t colors[3 * 256];
+	size_t n = std::min(frame.color_table->size(), (size_t) 256);
+
+	for (size_t i = 0; i < n; ++i) {
+		colors[3 * i] = (*frame.color_table)[i].data.red;
+		colors[3 * i + 1] = (*frame.color_table)[i].data.green;
+		colors[3 * i + 2] = (*frame.color_table)[i].data.blue;
+	}
+
+	uint64_t h = xxh64(fields, sizeof(fields));
+	h = xxh64(colors, 3 * n, h);
+	return xxh64(frame.img->compressed.data(), frame.img->compressed.size(), h);
+}
 
-	return generate_bmp(size, gif, &indexes, color_table, out_file);
+/**
+ * @brief  Preallocate decoder storage so that first conversions do not grow it
+ *
+ * @param ctx decoder working storage
+ * @param pixels expected number of pixels in an image
+ */
+void gif2bmp_warm(struct gif2bmp_ctx_t * ctx, size_t pixels) {
+	std::vector<uint8_t> buf;
+
+	ctx->indexes.resize(pixels);
+	ctx->row.reserve(3 * pixels);
+	ctx->pool.get(buf, pixels);
+	ctx->pool.put(buf);
+}
+
+/**
+ * @brief  Free decoder storage grown by big images, so that memory returned
+ * to budget is really free
+ *
+ * @param ctx decoder working storage
+ * @param pixels number of pixels of an image storage is kept for
+ */
+void gif2bmp_trim(struct gif2bmp_ctx_t * ctx, size_t pixels) {
+	if (ctx->indexes.capacity() > pixels)
+		std::vector<uint8_t>(pixels).swap(ctx->indexes);
+	if (ctx->row.capacity() > 3 * pixels) {
+		std::vector<uint8_t>().swap(ctx->row);
+		ctx->row.reserve(3 * pixels);
+	}
+	ctx->pool.trim(pixels);
+}
+
+/**
+ * @brief  Clear counters of conversion, frame_pixels is kept
+ *
+ * @param status status to clear
+ */
+void gif2bmp_reset_stats(struct gif2bmp_t * status) {
+	std::vector<uint64_t> * frame_pixels = status->frame_pixels;
+
+	memset(status, 0, sizeof(*status));
+	status->frame_pixels = frame_pixels;
+	if (frame_pixels)
+		frame_pixels->clear();
+}
+
+/**
+ * @brief  Preview of interlaced image written while it is decoded
+ */
+struct preview_t {
+	const char * path;								///< BMP to replace
+	Gif * gif;
+	GifImgData * img;								///< Image being decoded
+	const struct gif2bmp_frame_t * frame;		///< Color table of image
+	const struct gif2bmp_view_t * view;
+	struct gif2bmp_ctx_t * ctx;
+};
+
+/**
+ * @brief  Write preview when a pass of interlaced image is decoded
+ *
+ * Preview is written to a temporary file which replaces the previous one,
+ * so readers never see a partial BMP. Time spent here is counted to decoding.
+ *
+ * @param pass complete pass, counted from 0
+ * @param plane image with rows of later passes filled
+ * @param arg preview_t of conversion
+ */
+static void write_preview(unsigned pass, const uint8_t * plane, void * arg) {
+	struct preview_t * preview = (struct preview_t *) arg;
+	struct gif2bmp_frame_t frame = *preview->frame;
+	const struct region_t whole = { 0, 0, preview->img->image_desc.width,
+			preview->img->image_desc.height };
+	std::string tmp = std::string(preview->path) + ".part";
+	size_t size = 0;
+
+	TRACE_SPAN("preview", pass);
+	frame.img = preview->img;
+	frame.indexes = plane;
+	frame.count = whole.width * whole.height;
+	frame.region = whole;
+
+	FILE * f = fopen(tmp.c_str(), "wb");
+	if (! f) {
+		warn() << "Cannot write preview '" << tmp << "': " << strerror(errno) << "\n";
+		return;
+	}
+	bool ok = write_bmp(size, frame, preview->gif, f, preview->ctx, NULL, *preview->view);
+	ok = fclose(f) == 0 && ok;
+	if (! ok || rename(tmp.c_str(), preview->path) != 0) {
+		warn() << "Cannot write preview '" << preview->path << "'!\n";
+		unlink(tmp.c_str());
+		return;
+	}
+
+	info() << "Preview of pass " << pass + 1 << " written to '" << preview->path << "'\n";
+}
+
+/**
+ * @brief  Convert first image of parsed GIF
+ *
+ * @param gif parsed GIF
+ * @param ctx decoder working storage
+ * @param status counters to update, may be NULL
+ * @param out size of image, may be NULL
+ * @param out_file output file (BMP)
+ * @param size size of written BMP
+ *
+ * @return  true on success
+ */
+static bool convert_parsed(Gif & gif, struct gif2bmp_ctx_t * ctx, struct gif2bmp_t * status,
+		const struct gif2bmp_out_t * out, FILE * out_file, size_t & size) {
+	struct gif2bmp_frame_t frame;
+	struct gif2bmp_view_t view;
+	MemoryReservation memory;
+
+	if (gif.num_imgs() == 0) {
+		err() << "GIF has no image!\n";
+		return false;
+	}
+
+	if (! memory.ensure(memory_needed(gif.m_header, gif.get_image(0)))
+			|| ! gif2bmp_view(&gif, out, view))
+		return false;
+
+	GifImgData * img = gif.get_image(0);
+	struct preview_t preview = { out ? out->preview : NULL, &gif, img, &frame, &view, ctx };
+	if (preview.path && ! view.crop && img->has_interlace())
+		ctx->lzw.set_pass_listener(write_preview, &preview, out->preview_passes);
+
+	TRACE_SPAN("frame", 0);
+	bool ok = decode_image(img, &gif, ctx, status, frame, view.crop ? &view.region : NULL);
+	ctx->lzw.set_pass_listener(NULL, NULL, 0);
+
+	return ok && write_bmp(size, frame, &gif, out_file, ctx, status, view);
 }
 
 /**
  * @brief  Convert GIF to BMP
  *
- * @param status output status (compressed / decompressed size)
+ * @param status output status (sizes, timing and decoder counters), may be NULL
  * @param in_file input file (GIF)
  * @param out_file output file (BMP), when NULL creates image for every image in
  * GIF
+ * @param ctx decoder working storage to reuse, when NULL a temporary one is used
+ * @param out size of images and their destination when out_file is NULL, when
+ * NULL images are full size and every one is written to a separate file
  *
  * @return  0 on success
  */
-int gif2bmp(struct gif2bmp_t * status, FILE * in_file, FILE * out_file) {
-	Gif gif;
-	size_t size_bmp;
+int gif2bmp(struct gif2bmp_t * status, FILE * in_file, FILE * out_file, struct gif2bmp_ctx_t * ctx,
+		const struct gif2bmp_out_t * out) {
+	struct gif2bmp_ctx_t * local_ctx = NULL;
+	size_t size_bmp = 0;
+	uint64_t allocs = alloc_count();
+	int res = 0;
 
-	if (! gif.parse(in_file)) {
-		err() << "Parse FAILED due to fatal errors!\n";
-		return 1;
-	}
+	if (! ctx)
+		ctx = local_ctx = new struct gif2bmp_ctx_t;
+
+	Gif & gif = ctx->gif;
+
+	if (status)
+		gif2bmp_reset_stats(status);
 
 	if (out_file != NULL) {
-		if (! decode_lzw(size_bmp, gif.get_image(0), &gif, out_file))
-			return false;
+		gif.reset();
+
+		bool parsed;
+		{
+			StageTimer timer(status ? &status->stages[kStageParse] : NULL);
+			parsed = gif.parse(in_file);
+		}
+		if (status)
+			status->parse = gif.m_stats;
+
+		if (! parsed) {
+			err() << "Parse FAILED due to fatal errors!\n";
+			res = 1;
+		} else if (! convert_parsed(gif, ctx, status, out, out_file, size_bmp)) {
+			res = 1;
+		}
 	} else {
-		char * filename = new char[kMaxFileNameSize];
-		FILE * f = NULL;
+		/*
+		 * images are written as they are read, only one is kept in memory
+		 */
+		FrameReader reader(in_file, ctx, status);
+		struct gif2bmp_frame_t frame;
 		size_t size_tmp = 0;
 
+		/*
+		 * identical images are recognized by their compressed data, before
+		 * they are decoded
+		 */
+		std::unordered_map<uint64_t, size_t> written;
+		struct gif2bmp_view_t view;
 
-		for (unsigned i = 0; i < gif.num_imgs(); ++i) {
-			sprintf(filename, "%04u.bmp", i+1);
-			f = fopen(filename, "wb");
-			if (f) {
-				if (! decode_lzw(size_tmp, gif.get_image(i), &gif, f)) {
+		bool started = reader.start();
+		if (started && ! gif2bmp_view(&gif, out, view)) {
+			started = false;
+			res = 1;
+		}
+
+		if (started) {
+			const size_t width = view.width;
+			const size_t height = view.height;
+			const struct region_t * crop = view.crop ? &view.region : NULL;
+
+			while (reader.read(frame)) {
+				TRACE_SPAN("frame", frame.index);
+				if (out && out->dedup) {
+					/*
+					 * position of image in cropped BMP depends on descriptor
+					 */
+					uint64_t key = gif2bmp_image_key(frame);
+					if (crop) {
+						const uint16_t pos[] = { frame.img->image_desc.left, frame.img->image_desc.top };
+						key = xxh64(pos, sizeof(pos), key);
+					}
+					std::pair<std::unordered_map<uint64_t, size_t>::iterator, bool> it =
+							written.insert(std::make_pair(key, frame.index));
+					if (! it.second) {
+						if (gif2bmp_link_image(frame.index, it.first->second,
+									bmp_file_size(width, height), out, status))
+							continue;
+						res = 1;
+						break;
+					}
+				}
+
+				if (! reader.decode(frame, crop))
+					break;
+				FILE * f = gif2bmp_open_image(frame.index, width, height, out);
+				if (! f) {
+					res = 1;
 					break;
 				}
-				size_tmp += size_bmp;
-			} else {
-				err() << "Failed to create file '" << filename << "'\n";
-				delete [] filename;
-				return 1;
+				bool ok = write_bmp(size_tmp, frame, &gif, f, ctx, status, view);
+				ok = gif2bmp_close_image(f, out) && ok;
+				if (! ok) {
+					res = 1;
+					break;
+				}
+				size_bmp += size_tmp;
 			}
 		}
 
-		delete [] filename;
+		if (reader.failed()) {
+			err() << "Parse FAILED due to fatal errors!\n";
+			res = 1;
+		}
+		if (! gif2bmp_finish_images(out, status))
+			res = 1;
 	}
 
-	if (status) {
+	delete local_ctx;
+
+	if (res == 0 && status) {
 		/*
 		 * get GIF size
 		 */
@@ -411,8 +738,362 @@ int gif2bmp(struct gif2bmp_t * status, FILE * in_file, FILE * out_file) {
 		 * get BMP size
 		 */
 		status->bmp_size = size_bmp;
+		status->allocs = alloc_count() - allocs;
+	}
+
+	return res;
+}
+
+/**
+ * @brief  Output BMP of one GIF of stream
+ *
+ * @param i index of GIF in stream counted from 0
+ * @param result "OK", "ERR conversion failed" or "ERR parse failed"
+ * @param bmp converted BMP, NULL when conversion failed
+ * @param size size of BMP
+ * @param gif GIF the BMP was converted from
+ * @param out_file output of framed BMPs, NULL for files NNNN.bmp
+ * @param out size of images and their destination when out_file is NULL
+ *
+ * @return  false when output failed
+ */
+static bool stream_output(size_t i, const char * result, const char * bmp, size_t size,
+		const Gif * gif, FILE * out_file, const struct gif2bmp_out_t * out) {
+	if (out_file) {
+		bool ok = bmp ? fprintf(out_file, "%s %zu\n", result, size) > 0
+					&& fwrite(bmp, 1, size, out_file) == size
+				: fprintf(out_file, "%s\n", result) > 0;
+		if (! ok || fflush(out_file) != 0) {
+			err() << "Failed to write output!\n";
+			return false;
+		}
+		return true;
+	}
+
+	if (! bmp)
+		return true;
+
+	struct gif2bmp_view_t view;
+	if (! gif2bmp_view(gif, out, view))
+		return false;
+
+	FILE * f = gif2bmp_open_image(i, view.width, view.height, out);
+	if (! f)
+		return false;
+	bool ok = fwrite(bmp, 1, size, f) == size;
+	return gif2bmp_close_image(f, out) && ok;
+}
+
+/**
+ * @brief  Convert GIFs which follow each other in one stream, every GIF is
+ * converted as soon as its trailer is read
+ *
+ * Nothing after trailer is read before the GIF is converted, so GIFs can be
+ * pushed to a pipe one by one. Every GIF gives one BMP as plain conversion
+ * does. To out_file every BMP goes as "OK <size>\n" followed by BMP, or
+ * "ERR <reason>\n" when the GIF was not converted. A GIF which cannot be
+ * parsed ends the stream, the start of the next one is not known.
+ *
+ * @param status output status, sums over all GIFs, may be NULL
+ * @param in_file input stream of GIFs
+ * @param out_file output of framed BMPs, when NULL BMP of GIF N is written to
+ * file N.bmp (0001.bmp...)
+ * @param ctx decoder working storage to reuse, when NULL a temporary one is used
+ * @param out size of images and their destination when out_file is NULL, may
+ * be NULL
+ * @param count number of GIFs read, may be NULL
+ *
+ * @return  0 when all GIFs were converted
+ */
+int gif2bmp_stream(struct gif2bmp_t * status, FILE * in_file, FILE * out_file,
+		struct gif2bmp_ctx_t * ctx, const struct gif2bmp_out_t * out, size_t * count) {
+	struct gif2bmp_ctx_t * local_ctx = NULL;
+	uint64_t allocs = alloc_count();
+	int64_t gif_size = 0;
+	int64_t bmp_size = 0;
+	struct Gif::stats_t parse;
+	size_t gifs = 0;
+	int res = 0;
+
+	if (! ctx)
+		ctx = local_ctx = new struct gif2bmp_ctx_t;
+
+	Gif & gif = ctx->gif;
+
+	if (status)
+		gif2bmp_reset_stats(status);
+	memset(&parse, 0, sizeof(parse));
+	gif.set_concatenated(true);
+
+	for (;;) {
+		int c = fgetc(in_file);
+		if (c == EOF)
+			break;
+		ungetc(c, in_file);
+
+		const size_t i = gifs++;
+		TRACE_SPAN("gif", i);
+		bool parsed;
+		{
+			StageTimer timer(status ? &status->stages[kStageParse] : NULL);
+			gif.reset();
+			parsed = gif.parse(in_file);
+		}
+		parse.bytes += gif.m_stats.bytes;
+		parse.sub_blocks += gif.m_stats.sub_blocks;
+		parse.images += gif.m_stats.images;
+		parse.pixels += gif.m_stats.pixels;
+
+		char * bmp = NULL;
+		size_t bmp_len = 0;
+		size_t size = 0;
+		bool ok = false;
+
+		if (! parsed) {
+			err() << "Parse FAILED due to fatal errors!\n";
+		} else {
+			FILE * mem = open_memstream(&bmp, &bmp_len);
+			ok = mem && convert_parsed(gif, ctx, status, out, mem, size);
+			ok = mem && fclose(mem) == 0 && ok;
+		}
+
+		const char * result = ok ? "OK" : parsed ? "ERR conversion failed" : "ERR parse failed";
+		bool written = stream_output(i, result, ok ? bmp : NULL, bmp_len, &gif, out_file, out);
+		free(bmp);
+
+		gif_size += gif.m_stats.bytes;
+		if (ok)
+			bmp_size += bmp_len;
+		if (! ok || ! written)
+			res = 1;
+		if (! parsed || ! written)
+			break;
+	}
+
+	gif.set_concatenated(false);
+	if (! gif2bmp_finish_images(out, status))
+		res = 1;
+	delete local_ctx;
+
+	if (count)
+		*count = gifs;
+	if (status) {
+		status->parse = parse;
+		status->gif_size = gif_size;
+		status->bmp_size = bmp_size;
+		status->allocs = alloc_count() - allocs;
+	}
+
+	return res;
+}
+
+/**
+ * @brief  Feed decoded image to hashes as BGR, rows top to bottom
+ *
+ * Pixels missing in image data and wrong indexes are black, as in BMP.
+ *
+ * @param frame decoded image
+ * @param row buffer for converted rows
+ * @param image hash of image
+ * @param file hash of all images
+ */
+static void hash_image(const struct gif2bmp_frame_t & frame, std::vector<uint8_t> & row,
+		Xxh64 & image, Xxh64 & file) {
+	const size_t width = frame.img->image_desc.width;
+	const size_t height = frame.img->image_desc.height;
+	const size_t colors = frame.color_table->size();
+	const size_t chunk = width ? std::max(kHashChunkSize / (3 * width), (size_t) 1) : 1;
+
+	if (row.size() < 3 * width * std::min(chunk, height))
+		row.resize(3 * width * std::min(chunk, height));
+
+	for (size_t y = 0; y < height; ) {
+		size_t rows = std::min(chunk, height - y);
+		uint8_t * p = row.data();
+
+		for (size_t i = y * width; i < (y + rows) * width; ++i, p += 3) {
+			if (i < frame.count && frame.indexes[i] < colors) {
+				const Gif::color_item_t & item = (*frame.color_table)[frame.indexes[i]];
+				p[0] = item.data.blue;
+				p[1] = item.data.green;
+				p[2] = item.data.red;
+			} else {
+				p[0] = p[1] = p[2] = 0;
+			}
+		}
+
+		image.update(row.data(), 3 * width * rows);
+		file.update(row.data(), 3 * width * rows);
+		y += rows;
+	}
+}
+
+/**
+ * @brief  Decode GIF and print XXH64 of every image and of all of them,
+ * nothing else is written
+ *
+ * Hashes are computed over BGR pixels of image rectangles, rows top to
+ * bottom, so they do not depend on BMP layout.
+ *
+ * @param status output status, may be NULL
+ * @param in_file input file (GIF)
+ * @param out_file output file, one "frame[N] = HASH" line per image and
+ * "file = HASH"
+ * @param ctx decoder working storage to reuse, when NULL a temporary one is used
+ *
+ * @return  0 on success
+ */
+int gif2bmp_hash(struct gif2bmp_t * status, FILE * in_file, FILE * out_file,
+		struct gif2bmp_ctx_t * ctx) {
+	struct gif2bmp_ctx_t * local_ctx = NULL;
+	uint64_t allocs = alloc_count();
+	int res = 0;
+
+	if (! ctx)
+		ctx = local_ctx = new struct gif2bmp_ctx_t;
+
+	if (status)
+		gif2bmp_reset_stats(status);
+
+	FrameReader reader(in_file, ctx, status);
+	struct gif2bmp_frame_t frame;
+	Xxh64 file_hash;
+	Xxh64 image_hash;
+
+	if (reader.start()) {
+		while (reader.next(frame)) {
+			TRACE_SPAN("hash", frame.index);
+			StageTimer timer(status ? &status->stages[kStageConvert] : NULL);
+
+			image_hash.reset();
+			hash_image(frame, ctx->row, image_hash, file_hash);
+			fprintf(out_file, "frame[%zu] = %016" PRIx64 "\n", frame.index, image_hash.digest());
+		}
+	}
+
+	if (reader.failed()) {
+		err() << "Parse FAILED due to fatal errors!\n";
+		res = 1;
+	} else {
+		fprintf(out_file, "file = %016" PRIx64 "\n", file_hash.digest());
 	}
 
-	return 0;
+	delete local_ctx;
+
+	if (res == 0 && status) {
+		status->gif_size = status->parse.bytes;
+		status->allocs = alloc_count() - allocs;
+	}
+
+	return res;
+}
+
+
+/**
+ * @brief  Add error found by gif2bmp_verify()
+ */
+static void add_error(std::vector<struct gif2bmp_error_t> & errors, size_t image,
+		enum verify_error_t error, uint64_t position, uint64_t value = 0, uint64_t expected = 0) {
+	struct gif2bmp_error_t e = { image, error, position, value, expected };
+	errors.push_back(e);
 }
 
+/**
+ * @brief  Check GIF structure and image data without decoding pixels
+ *
+ * Every image is checked by LzwDecoder::check(), so all images are verified
+ * even when some have wrong data. Checking stops only when GIF cannot be
+ * parsed further.
+ *
+ * @param status output status, may be NULL
+ * @param in_file input file (GIF)
+ * @param images number of images found
+ * @param errors errors found, in order of images
+ * @param ctx decoder working storage to reuse, when NULL a temporary one is used
+ *
+ * @return  0 when GIF is valid
+ */
+int gif2bmp_verify(struct gif2bmp_t * status, FILE * in_file, size_t & images,
+		std::vector<struct gif2bmp_error_t> & errors, struct gif2bmp_ctx_t * ctx) {
+	struct gif2bmp_ctx_t * local_ctx = NULL;
+	long start = ftell(in_file);
+
+	if (! ctx)
+		ctx = local_ctx = new struct gif2bmp_ctx_t;
+
+	if (status)
+		gif2bmp_reset_stats(status);
+
+	FrameReader reader(in_file, ctx, status);
+	struct gif2bmp_frame_t frame;
+	struct lzw_check_t check;
+
+	images = 0;
+	errors.clear();
+
+	if (reader.start()) {
+		while (reader.read(frame)) {
+			TRACE_SPAN("check", frame.index);
+			StageTimer timer(status ? &status->stages[kStageDecode] : NULL);
+			const Gif::image_descriptor_t & desc = frame.img->image_desc;
+			uint64_t pixels = (uint64_t) desc.width * desc.height;
+
+			images++;
+			if (status)
+				status->frames++;
+			if (! ctx->lzw.check(frame.img, check)) {
+				switch (check.error) {
+					case lzw_check_t::kNoData:
+						add_error(errors, frame.index, kVerifyNoData, 0);
+						break;
+					case lzw_check_t::kMinCodeSize:
+						add_error(errors, frame.index, kVerifyMinCodeSize, 0, check.code);
+						break;
+					case lzw_check_t::kBadCode:
+						add_error(errors, frame.index, kVerifyBadCode, check.codes, check.code, check.next);
+						break;
+					default:
+						add_error(errors, frame.index, kVerifyNoEnd, check.codes);
+						break;
+				}
+			}
+
+			if ((check.error == lzw_check_t::kOk || check.error == lzw_check_t::kNoEnd)
+					&& check.pixels != pixels)
+				add_error(errors, frame.index, kVerifyPixels, check.codes, check.pixels, pixels);
+		}
+	}
+
+	if (reader.failed()) {
+		long end = ftell(in_file);
+		add_error(errors, images, kVerifyParse, start >= 0 && end >= start ? end - start : 0);
+	}
+
+	delete local_ctx;
+
+	if (status)
+		status->gif_size = status->parse.bytes;
+
+	return errors.empty() ? 0 : 1;
+}
+
+/**
+ * @brief  Print result of gif2bmp_verify() as JSON
+ *
+ * @param out output file
+ * @param images number of images found
+ * @param errors errors found
+ */
+void gif2bmp_verify_json(FILE * out, size_t images, const std::vector<struct gif2bmp_error_t> & errors) {
+	fprintf(out, "{\n  \"valid\": %s,\n  \"images\": %zu,\n  \"errors\": [",
+			errors.empty() ? "true" : "false", images);
+
+	for (size_t i = 0; i < errors.size(); ++i) {
+		const struct gif2bmp_error_t & e = errors[i];
+		fprintf(out, "%s\n    { \"image\": %zu, \"error\": \"%s\", \"position\": %" PRIu64
+				", \"value\": %" PRIu64 ", \"expected\": %" PRIu64 " }",
+				i ? "," : "", e.image, kVerifyErrorNames[e.error], e.position, e.value, e.expected);
+	}
+
+	fputs(errors.empty() ? "]\n}\n" : "\n  ]\n}\n", out);
+}
\ No newline at end of file
@@ -14,14 +14,188 @@
 #include <inttypes.h>
 #include <cstdio>
 
+#include <vector>
+
+#include "gif.h"
+#include "lzw.h"
+#include "pool.h"
+#include "timer.h"
+#include "tar.h"
+#include "writer.h"
+#include "budget.h"
+
+/**
+ * @brief  Stages of conversion which are timed
+ */
+enum stage_t {
+	kStageParse,
+	kStageDecode,
+	kStageConvert,
+	kStageWrite,
+	kStageCount
+};
+
+extern const char * const kStageNames[kStageCount];
+
 /**
- * @brief  Sizes of input/output in total
+ * @brief  Sizes of input/output in total and conversion counters
  */
 struct gif2bmp_t {
 	int64_t bmp_size;
 	int64_t gif_size;
+	uint64_t allocs;								///< Heap allocations done by the conversion
+	uint64_t frames;								///< Images decoded
+	uint64_t dedup_frames;						///< Images linked to identical ones
+	uint64_t dedup_bytes;						///< Bytes not written thanks to links
+	struct stage_time_t stages[kStageCount];
+	struct Gif::stats_t parse;
+	struct lzw_stats_t lzw;						///< Sum over decoded images
+	/**
+	 * Set by caller to get number of pixels of every decoded image, may be NULL
+	 */
+	std::vector<uint64_t> * frame_pixels;
+};
+
+/**
+ * @brief  Errors found by gif2bmp_verify()
+ */
+enum verify_error_t {
+	kVerifyParse,					///< GIF structure is broken, position is byte offset
+	kVerifyNoData,					///< Image has no data
+	kVerifyMinCodeSize,			///< Value is wrong LZW minimum code size
+	kVerifyBadCode,				///< Value is code not in dictionary, expected next code
+	kVerifyNoEnd,					///< End Of Image code is missing
+	kVerifyPixels,					///< Value is pixels in data, expected pixels of image
+	kVerifyErrorCount
+};
+
+extern const char * const kVerifyErrorNames[kVerifyErrorCount];
+
+/**
+ * @brief  Error found by gif2bmp_verify()
+ */
+struct gif2bmp_error_t {
+	size_t image;					///< Image counted from 0
+	enum verify_error_t error;
+	uint64_t position;			///< Codes read from image data, bytes for kVerifyParse
+	uint64_t value;
+	uint64_t expected;
+};
+
+/**
+ * @brief  Decoder working storage which can be kept between conversions
+ *
+ * Everything a conversion needs is owned here and only reset, never freed,
+ * when the next conversion starts. Once buffers have grown to the size of
+ * the images being converted, conversions do not allocate.
+ */
+struct gif2bmp_ctx_t {
+	class BufferPool pool;				///< Image data buffers
+	class Gif gif;							///< Parsed GIF, images are recycled
+	class LzwDecoder lzw;				///< LZW dictionary
+	std::vector<uint8_t> indexes;		///< Decoded indexes to color table
+	std::vector<uint8_t> row;			///< BMP row being written
+	std::vector<uint64_t> sums;		///< Sums of pixels of downscaled BMP row
+
+	gif2bmp_ctx_t() : gif(&pool) { }
+};
+
+/**
+ * @brief  Decoded image yielded by FrameReader
+ */
+struct gif2bmp_frame_t {
+	size_t index;												///< Counted from 0
+	class GifImgData * img;									///< Descriptor, valid until next image
+	const std::vector<Gif::color_item_t> * color_table;	///< Local or global table
+	const uint8_t * indexes;									///< Decoded indexes, rows top to bottom
+	size_t count;												///< Number of decoded indexes
+	struct region_t region;									///< Part of image decoded to indexes
 };
 
-int gif2bmp(struct gif2bmp_t * status, FILE * in_file, FILE * out_file);
+/**
+ * @brief  Read and decode images of GIF one at a time
+ *
+ * Image data and decoded indexes of an image are recycled when the next one
+ * is read, so memory depends on size of images and not on their number.
+ */
+class FrameReader {
+public:
+	FrameReader(FILE * f, struct gif2bmp_ctx_t * ctx, struct gif2bmp_t * status = NULL);
+
+	bool start();
+	bool next(struct gif2bmp_frame_t & frame);
+	bool read(struct gif2bmp_frame_t & frame);
+	bool decode(struct gif2bmp_frame_t & frame, const struct region_t * view = NULL);
+
+	/**
+	 * @brief  Whether reading stopped on error rather than at end of GIF
+	 */
+	bool failed() const { return m_failed; }
+
+	class Gif * gif() { return &m_ctx->gif; }
+
+private:
+	void stop();
+
+	FILE * m_file;
+	struct gif2bmp_ctx_t * m_ctx;
+	struct gif2bmp_t * m_status;	///< May be NULL
+	class MemoryReservation m_memory;	///< Memory for screen and largest image so far
+	size_t m_index;					///< Index of next image
+	long m_start;						///< Offset of GIF in m_file
+	bool m_failed;
+}; // class FrameReader
+
+/**
+ * @brief  Size of output images and destination of images extracted by -e,
+ * plain files when pointers are NULL
+ */
+struct gif2bmp_out_t {
+	class TarWriter * tar;				///< Archive to write images to
+	class AsyncWriter * writer;		///< Writer of files in background
+	bool dedup;							///< Link images identical to earlier ones
+	unsigned scale;						///< Downscale by this factor, 0 or 1 for full size
+	unsigned max_dim;					///< Downscale so that no side is longer, 0 for no limit
+	const struct region_t * crop;		///< Part of screen to write, NULL for whole screen
+	const char * preview;				///< BMP replaced by preview of interlaced image, may be NULL
+	unsigned preview_passes;			///< Passes after which preview is written, 1 or 2
+};
+
+/**
+ * @brief  Part of screen written to BMP and its size
+ */
+struct gif2bmp_view_t {
+	struct region_t region;				///< Cropped screen
+	unsigned factor;						///< BMP is downscaled by factor, 1 for full size
+	bool crop;								///< Only decoded parts of images within region are written
+	size_t width;							///< Width of BMP
+	size_t height;							///< Height of BMP
+};
+
+FILE * gif2bmp_open_image(size_t i, size_t width, size_t height, const struct gif2bmp_out_t * out);
+bool gif2bmp_close_image(FILE * f, const struct gif2bmp_out_t * out);
+bool gif2bmp_finish_images(const struct gif2bmp_out_t * out, struct gif2bmp_t * status);
+bool gif2bmp_link_image(size_t i, size_t target, uint64_t size, const struct gif2bmp_out_t * out,
+		struct gif2bmp_t * status);
+uint64_t gif2bmp_image_key(const struct gif2bmp_frame_t & frame);
+bool gif2bmp_view(const class Gif * gif, const struct gif2bmp_out_t * out, struct gif2bmp_view_t & view);
+struct region_t gif2bmp_image_region(const class GifImgData * img, const struct region_t & view);
+
+void gif2bmp_warm(struct gif2bmp_ctx_t * ctx, size_t pixels);
+void gif2bmp_trim(struct gif2bmp_ctx_t * ctx, size_t pixels);
+
+void gif2bmp_reset_stats(struct gif2bmp_t * status);
+void gif2bmp_count_image(struct gif2bmp_t * status, const struct lzw_stats_t & lzw, size_t count);
+
+int gif2bmp(struct gif2bmp_t * status, FILE * in_file, FILE * out_file,
+		struct gif2bmp_ctx_t * ctx = NULL, const struct gif2bmp_out_t * out = NULL);
+int gif2bmp_stream(struct gif2bmp_t * status, FILE * in_file, FILE * out_file,
+		struct gif2bmp_ctx_t * ctx = NULL, const struct gif2bmp_out_t * out = NULL,
+		size_t * count = NULL);
+int gif2bmp_hash(struct gif2bmp_t * status, FILE * in_file, FILE * out_file,
+		struct gif2bmp_ctx_t * ctx = NULL);
+int gif2bmp_verify(struct gif2bmp_t * status, FILE * in_file, size_t & images,
+		std::vector<struct gif2bmp_error_t> & errors, struct gif2bmp_ctx_t * ctx = NULL);
+void gif2bmp_verify_json(FILE * out, size_t images, const std::vector<struct gif2bmp_error_t> & errors);
 
 #endif // GIF2BMP_H_
@@ -0,0 +1,192 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 11:02:17 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstring>
+
+#include "hash.h"
+
+static const uint64_t kPrime1 = 11400714785074694791ULL;
+static const uint64_t kPrime2 = 14029467366897019727ULL;
+static const uint64_t kPrime3 =  1609587929392839161ULL;
+static const uint64_t kPrime4 =  9650029242287828579ULL;
+static const uint64_t kPrime5 =  2870177450012600261ULL;
+
+static inline uint64_t rotl(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t * p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t read32(const uint8_t * p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t acc_round(uint64_t acc, uint64_t input) {
+	acc += input * kPrime2;
+	acc = rotl(acc, 31);
+	return acc * kPrime1;
+}
+
+static inline uint64_t merge_round(uint64_t acc, uint64_t val) {
+	acc ^= acc_round(0, val);
+	return acc * kPrime1 + kPrime4;
+}
+
+/**
+ * @brief  Mix in tail of input (less than 32 bytes) and avalanche
+ */
+static uint64_t finalize(uint64_t h, const uint8_t * p, const uint8_t * end) {
+	while (p + 8 <= end) {
+		h ^= acc_round(0, read64(p));
+		h = rotl(h, 27) * kPrime1 + kPrime4;
+		p += 8;
+	}
+
+	if (p + 4 <= end) {
+		h ^= (uint64_t) read32(p) * kPrime1;
+		h = rotl(h, 23) * kPrime2 + kPrime3;
+		p += 4;
+	}
+
+	while (p < end) {
+		h ^= (*p) * kPrime5;
+		h = rotl(h, 11) * kPrime1;
+		p++;
+	}
+
+	h ^= h >> 33;
+	h *= kPrime2;
+	h ^= h >> 29;
+	h *= kPrime3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+/**
+ * @brief  Merge accumulators of 32 byte stripes
+ */
+static uint64_t converge(const uint64_t v[4]) {
+	uint64_t h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+
+	h = merge_round(h, v[0]);
+	h = merge_round(h, v[1]);
+	h = merge_round(h, v[2]);
+	h = merge_round(h, v[3]);
+	return h;
+}
+
+/**
+ * @brief  Compute XXH64 of a buffer
+ *
+ * @param data data to hash
+ * @param len size of data
+ * @param seed hash seed
+ *
+ * @return  64bit hash
+ */
+uint64_t xxh64(const void * data, size_t len, uint64_t seed) {
+	const uint8_t * p = (const uint8_t *) data;
+	const uint8_t * end = p + len;
+	uint64_t h;
+
+	if (len >= 32) {
+		const uint8_t * limit = end - 32;
+		uint64_t v[4] = { seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1 };
+
+		do {
+			v[0] = acc_round(v[0], read64(p)); p += 8;
+			v[1] = acc_round(v[1], read64(p)); p += 8;
+			v[2] = acc_round(v[2], read64(p)); p += 8;
+			v[3] = acc_round(v[3], read64(p)); p += 8;
+		} while (p <= limit);
+
+		h = converge(v);
+	} else {
+		h = seed + kPrime5;
+	}
+
+	return finalize(h + (uint64_t) len, p, end);
+}
+
+/**
+ * @brief  Start new hash
+ *
+ * @param seed hash seed
+ */
+void Xxh64::reset(uint64_t seed) {
+	m_seed = seed;
+	m_v[0] = seed + kPrime1 + kPrime2;
+	m_v[1] = seed + kPrime2;
+	m_v[2] = seed;
+	m_v[3] = seed - kPrime1;
+	m_len = 0;
+	m_buffered = 0;
+}
+
+/**
+ * @brief  Add data to hash
+ *
+ * @param data data to hash
+ * @param len size of data
+ */
+void Xxh64::update(const void * data, size_t len) {
+	const uint8_t * p = (const uint8_t *) data;
+	const uint8_t * end = p + len;
+
+	m_len += len;
+
+	if (m_buffered + len < sizeof(m_buffer)) {
+		memcpy(m_buffer + m_buffered, p, len);
+		m_buffered += len;
+		return;
+	}
+
+	if (m_buffered) {
+		size_t n = sizeof(m_buffer) - m_buffered;
+		memcpy(m_buffer + m_buffered, p, n);
+		p += n;
+		stripe(m_buffer);
+		m_buffered = 0;
+	}
+
+	for (; p + sizeof(m_buffer) <= end; p += sizeof(m_buffer))
+		stripe(p);
+
+	m_buffered = end - p;
+	memcpy(m_buffer, p, m_buffered);
+}
+
+/**
+ * @brief  Hash of data added so far, more data can be added then
+ *
+ * @return  64bit hash, same as xxh64() of all data at once
+ */
+uint64_t Xxh64::digest() const {
+	uint64_t h = m_len >= sizeof(m_buffer) ? converge(m_v) : m_seed + kPrime5;
+
+	return finalize(h + m_len, m_buffer, m_buffer + m_buffered);
+}
+
+/**
+ * @brief  Consume one 32 byte stripe
+ */
+void Xxh64::stripe(const uint8_t * p) {
+	m_v[0] = acc_round(m_v[0], read64(p));
+	m_v[1] = acc_round(m_v[1], read64(p + 8));
+	m_v[2] = acc_round(m_v[2], read64(p + 16));
+	m_v[3] = acc_round(m_v[3], read64(p + 24));
+}
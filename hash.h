@@ -0,0 +1,45 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 11:02:17 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <inttypes.h>
+#include <cstddef>
+
+/*
+ * Built-in implementation of XXH64 (https://github.com/Cyan4973/xxHash),
+ * fast non-cryptographic hash used for content addressing
+ */
+
+uint64_t xxh64(const void * data, size_t len, uint64_t seed = 0);
+
+/**
+ * @brief  XXH64 of data given in parts
+ */
+class Xxh64 {
+public:
+	Xxh64(uint64_t seed = 0) { reset(seed); }
+
+	void reset(uint64_t seed = 0);
+	void update(const void * data, size_t len);
+	uint64_t digest() const;
+
+private:
+	void stripe(const uint8_t * p);
+
+	uint64_t m_v[4];
+	uint64_t m_seed;
+	uint64_t m_len;				///< Bytes added so far
+	uint8_t m_buffer[32];		///< Incomplete stripe
+	size_t m_buffered;
+};
+
+#endif // HASH_H_
@@ -0,0 +1,244 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 11:08:40 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "index.h"
+#include "hash.h"
+#include "common.h"
+
+static const char kIndexMagic[8]		= { 'G', 'I', 'F', 'I', 'D', 'X', 0, 1 };
+const uint32_t kIndexByteOrder		= 0x01020304;
+const size_t kIndexHashSize			= 4096;
+const uint64_t kMinImageSize			= 12;	///< Descriptor, LZW code size and terminator
+
+/**
+ * @brief  Index file header
+ */
+struct index_header_t {
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t frames;
+	uint64_t file_size;			///< Of GIF
+	int64_t mtime_sec;			///< Of GIF
+	int64_t mtime_nsec;
+	uint64_t head_hash;			///< XXH64 of first kIndexHashSize bytes of GIF
+	uint64_t size;
+	int32_t loop_count;
+	uint32_t global_colors;
+	uint16_t width;
+	uint16_t height;
+	uint8_t background;
+	char version[4];
+	uint8_t reserved[3];
+};
+
+/**
+ * @brief  Index record of one image
+ */
+struct index_frame_t {
+	uint64_t offset;
+	uint64_t data_offset;
+	uint64_t data_size;
+	uint32_t sub_blocks;
+	uint32_t keyframe;
+	uint32_t local_colors;
+	int32_t transparent;
+	uint16_t left;
+	uint16_t top;
+	uint16_t width;
+	uint16_t height;
+	uint16_t delay;
+	uint8_t interlace;
+	uint8_t has_gce;
+	uint8_t disposal;
+	uint8_t reserved[7];
+};
+
+/**
+ * @brief  Fill fields binding index to GIF file
+ *
+ * @return  false if GIF is not a regular file
+ */
+static bool identify(FILE * gif_file, struct index_header_t * h) {
+	struct stat st;
+	int fd = fileno(gif_file);
+	uint8_t head[kIndexHashSize];
+
+	if (fstat(fd, &st) != 0 || ! S_ISREG(st.st_mode))
+		return false;
+
+	ssize_t n = pread(fd, head, sizeof(head), 0);
+	if (n < 0)
+		return false;
+
+	h->file_size = st.st_size;
+	h->mtime_sec = st.st_mtim.tv_sec;
+	h->mtime_nsec = st.st_mtim.tv_nsec;
+	h->head_hash = xxh64(head, n);
+	return true;
+}
+
+/**
+ * @brief  Whether index file can hold the frames its header declares
+ *
+ * Checked before frames are allocated, so that a damaged header does not
+ * request gigabytes.
+ */
+static bool frames_fit(FILE * f, const struct index_header_t & h) {
+	struct stat st;
+
+	if (fstat(fileno(f), &st) != 0 || (uint64_t) st.st_size < sizeof(h))
+		return false;
+
+	uint64_t records = (st.st_size - sizeof(h)) / sizeof(struct index_frame_t);
+	return h.frames <= records && h.frames <= h.file_size / kMinImageSize;
+}
+
+/**
+ * @brief  Load frame index of GIF
+ *
+ * @param path index file
+ * @param gif_file GIF the index has to belong to
+ * @param info output metadata
+ *
+ * @return  true if index exists and matches GIF
+ */
+bool index_load(const char * path, FILE * gif_file, struct gif_info_t * info) {
+	struct index_header_t h, expected;
+	FILE * f = fopen(path, "rb");
+	bool ok = false;
+
+	if (! f)
+		return false;
+
+	if (fread(&h, sizeof(h), 1, f) == 1 && identify(gif_file, &expected)
+			&& memcmp(h.magic, kIndexMagic, sizeof(kIndexMagic)) == 0
+			&& h.byte_order == kIndexByteOrder
+			&& h.file_size == expected.file_size
+			&& h.mtime_sec == expected.mtime_sec
+			&& h.mtime_nsec == expected.mtime_nsec
+			&& h.head_hash == expected.head_hash
+			&& frames_fit(f, h)) {
+		memcpy(info->version, h.version, sizeof(info->version));
+		info->version[3] = '\0';
+		info->width = h.width;
+		info->height = h.height;
+		info->global_colors = h.global_colors;
+		info->background = h.background;
+		info->loop_count = h.loop_count;
+		info->size = h.size;
+		info->frames.resize(h.frames);
+
+		struct index_frame_t r;
+		ok = true;
+		for (uint32_t i = 0; ok && i < h.frames; ++i) {
+			struct gif_frame_info_t & fr = info->frames[i];
+			ok = fread(&r, sizeof(r), 1, f) == 1 && r.keyframe <= i;
+			fr.offset = r.offset;
+			fr.data_offset = r.data_offset;
+			fr.data_size = r.data_size;
+			fr.sub_blocks = r.sub_blocks;
+			fr.keyframe = r.keyframe;
+			fr.local_colors = r.local_colors;
+			fr.transparent = r.transparent;
+			fr.left = r.left;
+			fr.top = r.top;
+			fr.width = r.width;
+			fr.height = r.height;
+			fr.delay = r.delay;
+			fr.interlace = r.interlace;
+			fr.has_gce = r.has_gce;
+			fr.disposal = r.disposal;
+		}
+	}
+
+	fclose(f);
+	return ok;
+}
+
+/**
+ * @brief  Store frame index of GIF
+ *
+ * Index is written to a temporary file and renamed, so that readers never
+ * see a partial one.
+ *
+ * @param path index file
+ * @param gif_file GIF the index belongs to
+ * @param info metadata of GIF
+ *
+ * @return  true on success
+ */
+bool index_save(const char * path, FILE * gif_file, const struct gif_info_t * info) {
+	struct index_header_t h;
+
+	memset(&h, 0, sizeof(h));
+	if (! identify(gif_file, &h))
+		return false;
+
+	memcpy(h.magic, kIndexMagic, sizeof(kIndexMagic));
+	h.byte_order = kIndexByteOrder;
+	h.frames = info->frames.size();
+	h.size = info->size;
+	h.loop_count = info->loop_count;
+	h.global_colors = info->global_colors;
+	h.width = info->width;
+	h.height = info->height;
+	h.background = info->background;
+	memcpy(h.version, info->version, sizeof(h.version));
+
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%ld.tmp", (long) getpid());
+	std::string tmp_path = std::string(path) + suffix;
+
+	FILE * f = fopen(tmp_path.c_str(), "wb");
+	if (! f) {
+		warn() << "Cannot write frame index '" << tmp_path << "'\n";
+		return false;
+	}
+
+	bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+	for (size_t i = 0; ok && i < info->frames.size(); ++i) {
+		const struct gif_frame_info_t & fr = info->frames[i];
+		struct index_frame_t r;
+
+		memset(&r, 0, sizeof(r));
+		r.offset = fr.offset;
+		r.data_offset = fr.data_offset;
+		r.data_size = fr.data_size;
+		r.sub_blocks = fr.sub_blocks;
+		r.keyframe = fr.keyframe;
+		r.local_colors = fr.local_colors;
+		r.transparent = fr.transparent;
+		r.left = fr.left;
+		r.top = fr.top;
+		r.width = fr.width;
+		r.height = fr.height;
+		r.delay = fr.delay;
+		r.interlace = fr.interlace;
+		r.has_gce = fr.has_gce;
+		r.disposal = fr.disposal;
+		ok = fwrite(&r, sizeof(r), 1, f) == 1;
+	}
+
+	ok = (fclose(f) == 0) && ok;
+	if (! ok || rename(tmp_path.c_str(), path) != 0) {
+		warn() << "Cannot write frame index '" << path << "'\n";
+		unlink(tmp_path.c_str());
+		return false;
+	}
+
+	return true;
+}
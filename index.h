@@ -0,0 +1,28 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 11:08:40 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef INDEX_H_
+#define INDEX_H_
+
+#include <cstdio>
+
+#include "probe.h"
+
+/*
+ * Frame index is gif_info_t of a GIF stored in a file, so that the block
+ * structure does not have to be walked again. It is bound to the GIF by its
+ * size, modification time and hash of its beginning, and written in native
+ * byte order; an index which does not match is rebuilt.
+ */
+
+bool index_load(const char * path, FILE * gif_file, struct gif_info_t * info);
+bool index_save(const char * path, FILE * gif_file, const struct gif_info_t * info);
+
+#endif // INDEX_H_
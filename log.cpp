@@ -0,0 +1,113 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 07:26:03 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstring>
+#include <inttypes.h>
+
+#include <map>
+
+#include "common.h"
+
+/*
+ * Repeated warnings are printed this many times, the rest is only counted
+ */
+const uint64_t kLogRepeatLimit		= 5;
+
+int g_log_level = kLogInfo;
+
+/*
+ * Colors are used only when stderr is a terminal, checked once
+ */
+#ifdef __linux__
+bool g_log_tty = isatty(fileno(stderr));
+#else
+bool g_log_tty = false;
+#endif
+
+/*
+ * Counted per thread: every server and watch worker runs one conversion at
+ * a time, and its summary must not include or clear counts of others
+ */
+static thread_local std::map<const char *, uint64_t> t_repeated;
+
+/**
+ * @brief  Set up logging
+ *
+ * stderr is line buffered, so that a message is written at once and not
+ * piece by piece.
+ *
+ * @param level messages above level are dropped
+ */
+void log_init(int level) {
+	g_log_level = level;
+	setvbuf(stderr, NULL, _IOLBF, BUFSIZ);
+	std::cerr.unsetf(std::ios_base::unitbuf);
+}
+
+/**
+ * @brief  Get log level by name
+ *
+ * @param name quiet, error, warning or info
+ * @param level output level
+ *
+ * @return  true if name is known
+ */
+bool log_parse_level(const char * name, int & level) {
+	static const char * kNames[] = { "quiet", "error", "warning", "info" };
+
+	for (size_t i = 0; i < sizeof(kNames) / sizeof(kNames[0]); ++i) {
+		if (strcmp(name, kNames[i]) == 0) {
+			level = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief  Print warning which can repeat many times for one input
+ *
+ * @param msg whole message, has to be a string literal, occurrences are
+ * counted by its address
+ */
+void warn_repeated(const char * msg) {
+	if (g_log_level < kLogWarning)
+		return;
+
+	if (++t_repeated[msg] <= kLogRepeatLimit)
+		warn() << msg;
+}
+
+/**
+ * @brief  Print how many times repeated warnings were suppressed in calling
+ * thread since its last summary
+ */
+void log_summary() {
+	for (std::map<const char *, uint64_t>::iterator it = t_repeated.begin();
+			it != t_repeated.end(); ++it) {
+		if (it->second > kLogRepeatLimit)
+			warn() << "Suppressed " << std::dec
+					<< it->second - kLogRepeatLimit << " more of: " << it->first;
+	}
+
+	t_repeated.clear();
+	std::cerr.flush();
+}
+
+/**
+ * @brief  Stream which drops everything written to it
+ *
+ * Writes set badbit of the stream, so every thread has its own.
+ */
+std::ostream & log_null() {
+	static thread_local std::ostream null(NULL);
+	return null;
+}
@@ -0,0 +1,851 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 10:05:31 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstring>
+
+#include <algorithm>
+#include <thread>
+
+#include "lzw.h"
+#include "gif.h"
+#include "common.h"
+
+/*
+ * Interlaced images store rows in four passes
+ */
+static const size_t kPassStart[]	= { 0, 4, 2, 1 };
+static const size_t kPassStep[]	= { 8, 8, 4, 2 };
+static const size_t kPassDone[]	= { 8, 4, 2, 1 };	///< Decoded rows are multiples of it after pass
+
+static const char * const kMsgBadCode = "Bad index byte to dictionary. Image could be demaged!\n";
+
+LzwDecoder::LzwDecoder() : m_pass_fn(NULL), m_pass_arg(NULL), m_pass_limit(0),
+		m_bits(NULL, 0), m_done(true) {
+}
+
+/**
+ * @brief  Report passes of interlaced images decoded by decode()
+ *
+ * @param fn function called when a pass is complete, NULL to report none
+ * @param arg argument of fn
+ * @param passes number of passes reported, the last one is never reported
+ */
+void LzwDecoder::set_pass_listener(lzw_pass_fn fn, void * arg, unsigned passes) {
+	m_pass_fn = fn;
+	m_pass_arg = arg;
+	m_pass_limit = fn ? std::min(passes, 3U) : 0;
+}
+
+/**
+ * @brief  Fill rows of later passes by the nearest decoded row and report
+ * the pass
+ *
+ * Filled rows are overwritten by later passes or cleared at the end of
+ * data, so plane is used in place.
+ *
+ * @param pass complete pass
+ */
+void LzwDecoder::pass_done(unsigned pass) {
+	const size_t step = kPassDone[pass];
+	const size_t last = (m_height - 1) / step * step;
+
+	for (size_t row = 0; row < m_height; ++row) {
+		size_t src = row / step * step;
+		if (src == row)
+			continue;
+		if (2 * (row - src) > step && src + step <= last)
+			src += step;
+		memcpy(m_plane + row * m_width, m_plane + src * m_width, m_width);
+	}
+
+	m_pass_fn(pass, m_plane, m_pass_arg);
+}
+
+/**
+ * @brief  Move output to the next row of image
+ */
+void LzwDecoder::next_row() {
+	if (++m_rows_done >= m_height) {
+		m_out = NULL;
+		return;
+	}
+
+	if (m_interlace) {
+		m_row += kPassStep[m_pass];
+		while (m_row >= m_height) {
+			if (m_pass < m_pass_limit && kPassStart[m_pass] < m_height)
+				pass_done(m_pass);
+			m_pass++;
+			m_row = kPassStart[m_pass];
+		}
+	} else {
+		m_row++;
+	}
+
+	m_out = m_plane + m_row * m_width;
+	m_row_left = m_width;
+}
+
+/**
+ * @brief  Write string to output, pixels past the end of image are dropped
+ *
+ * @param str string to write
+ * @param len length of string
+ */
+void LzwDecoder::emit(const uint8_t * str, size_t len) {
+	while (len && m_out) {
+		size_t n = len < m_row_left ? len : m_row_left;
+		memcpy(m_out, str, n);
+		m_out += n;
+		m_row_left -= n;
+		m_written += n;
+		str += n;
+		len -= n;
+		if (m_row_left == 0)
+			next_row();
+	}
+}
+
+/**
+ * @brief  Write string of code to output
+ *
+ * @param code code to write
+ */
+void LzwDecoder::emit_code(unsigned code) {
+	size_t len = m_length[code];
+
+	if (len <= m_row_left && m_out) {
+		/*
+		 * Whole string fits to row, write it directly
+		 */
+		uint8_t * p = m_out + len;
+		for (unsigned c = code; p != m_out; c = m_prefix[c])
+			*--p = m_suffix[c];
+
+		m_out += len;
+		m_row_left -= len;
+		m_written += len;
+		if (m_row_left == 0)
+			next_row();
+	} else {
+		uint8_t * p = m_stack + len;
+		for (unsigned c = code; p != m_stack; c = m_prefix[c])
+			*--p = m_suffix[c];
+		emit(m_stack, len);
+	}
+}
+
+/**
+ * @brief  Decode image data to plane of indexes to color table
+ *
+ * @param img image to decode
+ * @param plane output of width * height bytes, rows are stored top to bottom
+ * (interlaced images are reordered)
+ * @param count number of indexes written to plane
+ *
+ * @return  true on success
+ */
+bool LzwDecoder::decode(GifImgData * img, uint8_t * plane, size_t & count) {
+	count = 0;
+	if (! start(img, plane))
+		return false;
+
+	step(kAllCodes);
+	count = m_written;
+	return true;
+}
+
+/**
+ * @brief  Start decoding image in steps, see step()
+ *
+ * Image data and plane have to be kept until decoding is done.
+ *
+ * @param img image to decode
+ * @param plane output of width * height bytes, rows are stored top to bottom
+ * (interlaced images are reordered)
+ *
+ * @return  false when image has no data or wrong minimum code size
+ */
+bool LzwDecoder::start(GifImgData * img, uint8_t * plane) {
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_written = 0;
+	m_done = true;
+
+	if (img->compressed.empty()) {
+		err() << "Missing image data!\n";
+		return false;
+	}
+
+	unsigned min_size = img->compressed[0];
+	if (min_size < 1 || min_size >= kMaxCodeSize) {
+		err() << "Wrong LZW minimum code size " << min_size << "!\n";
+		return false;
+	}
+
+	m_width = img->image_desc.width;
+	m_height = img->image_desc.height;
+	m_interlace = img->has_interlace();
+	m_plane = plane;
+	m_out = (m_width && m_height) ? plane : NULL;
+	m_row_left = m_width;
+	m_row = m_rows_done = 0;
+	m_pass = 0;
+
+	/*
+	 * Roots of dictionary, followed by Clear Code and End Of Image
+	 */
+	const unsigned clear = 1 << min_size;
+	for (unsigned i = 0; i < clear; ++i) {
+		m_suffix[i] = m_first[i] = i;
+		m_prefix[i] = 0;
+		m_length[i] = 1;
+	}
+
+	m_bits = BitReader(&img->compressed[1], img->compressed.size() - 1);
+	m_min_size = min_size;
+	m_next = clear + 2;
+	m_code_width = min_size + 1;
+	m_prev = -1;
+	m_codes = m_mark = 0;
+	m_done = false;
+	return true;
+}
+
+/**
+ * @brief  Decode next codes of image started by start()
+ *
+ * One code writes at most kMaxCodes pixels, so time of a call is bounded by
+ * max_codes. State is loaded to locals for the loop and stored back when
+ * it returns.
+ *
+ * @param max_codes maximal number of codes to read
+ *
+ * @return  true when image is done, count() indexes were written
+ */
+bool LzwDecoder::step(size_t max_codes) {
+	if (m_done)
+		return true;
+
+	const unsigned clear = 1 << m_min_size;
+	const unsigned eoi = clear + 1;
+	BitReader bits = m_bits;
+	unsigned next = m_next;
+	unsigned width = m_code_width;
+	unsigned code;
+	int prev = m_prev;
+	bool end = false;
+
+	/*
+	 * Codes are counted in a local, histogram of widths is updated only when
+	 * width changes
+	 */
+	uint64_t codes = m_codes;
+	uint64_t mark = m_mark;
+	const uint64_t stop = max_codes == kAllCodes ? (uint64_t) -1 : codes + max_codes;
+
+	while (codes < stop) {
+		if (! bits.read(width, code)) {
+			warn_repeated("Missing End Of Image code!\n");
+			end = true;
+			break;
+		}
+		codes++;
+
+		if (code == clear) {
+			m_stats.widths[width] += codes - mark;
+			m_stats.clears++;
+			mark = codes;
+			next = clear + 2;
+			width = m_min_size + 1;
+			prev = -1;
+			continue;
+		}
+
+		if (code == eoi) {
+			end = true;
+			break;
+		}
+
+		if (prev < 0) {
+			if (code >= clear) {
+				warn_repeated(kMsgBadCode);
+				end = true;
+				break;
+			}
+			emit_code(code);
+			prev = code;
+			continue;
+		}
+
+		uint8_t first;
+		if (code < next) {
+			emit_code(code);
+			first = m_first[code];
+		} else {
+			if (code != next)
+				warn_repeated(kMsgBadCode);
+			first = m_first[prev];
+			emit_code(prev);
+			emit(&first, 1);
+		}
+
+		if (next < kMaxCodes) {
+			m_prefix[next] = prev;
+			m_suffix[next] = first;
+			m_first[next] = m_first[prev];
+			m_length[next] = m_length[prev] + 1;
+			if (code >= next)
+				code = next;
+			next++;
+			if (next == (1U << width) && width < kMaxCodeSize) {
+				m_stats.widths[width] += codes - mark;
+				mark = codes;
+				width++;
+			}
+		}
+
+		prev = code;
+	}
+
+	m_bits = bits;
+	m_next = next;
+	m_code_width = width;
+	m_prev = prev;
+	m_codes = codes;
+	m_mark = mark;
+
+	if (! end)
+		return false;
+
+	m_stats.widths[width] += codes - mark;
+	m_stats.codes = codes;
+
+	/*
+	 * Rows of interlaced image are not contiguous, clear the missing ones
+	 */
+	if (m_interlace) {
+		while (m_out) {
+			memset(m_out, 0, m_row_left);
+			m_written += m_row_left;
+			next_row();
+		}
+	}
+
+	m_done = true;
+	return true;
+}
+
+/**
+ * @brief  Move output of decode_region() to the next row of image
+ */
+void LzwDecoder::next_region_row() {
+	m_column = 0;
+	if (m_row >= m_region.top && m_row < m_region.top + m_region.height)
+		m_rows_left--;
+
+	if (++m_rows_done >= m_height) {
+		m_rows_left = 0;
+		return;
+	}
+
+	if (m_interlace) {
+		m_row += kPassStep[m_pass];
+		while (m_row >= m_height) {
+			m_pass++;
+			m_row = kPassStart[m_pass];
+		}
+	} else {
+		m_row++;
+	}
+}
+
+/**
+ * @brief  Write part of string which falls into region, the rest is skipped
+ *
+ * @param code code of string, expanded only when some of it is written
+ * @param len length of string
+ * @param str expanded string, NULL to expand code
+ */
+void LzwDecoder::emit_region(unsigned code, size_t len, const uint8_t * str) {
+	const size_t right = m_region.left + m_region.width;
+	size_t pos = 0;
+
+	while (pos < len && m_rows_left) {
+		size_t n = std::min(len - pos, m_width - m_column);
+
+		if (m_row >= m_region.top && m_row < m_region.top + m_region.height) {
+			size_t a = std::max(m_column, m_region.left);
+			size_t b = std::min(m_column + n, right);
+			if (a < b) {
+				if (! str) {
+					uint8_t * p = m_stack + len;
+					for (unsigned c = code; p != m_stack; c = m_prefix[c])
+						*--p = m_suffix[c];
+					str = m_stack;
+				}
+				memcpy(m_plane + (m_row - m_region.top) * m_region.width + a - m_region.left,
+						str + pos + a - m_column, b - a);
+				m_written += b - a;
+			}
+		}
+
+		pos += n;
+		m_column += n;
+		if (m_column == m_width)
+			next_region_row();
+	}
+}
+
+/**
+ * @brief  Decode only region of image
+ *
+ * All codes up to the last row of region are read, but strings which fall
+ * outside of region are neither expanded nor written. Decoding stops as soon
+ * as all rows of region are complete.
+ *
+ * @param img image to decode
+ * @param region part of image, within image
+ * @param plane output of region width * height bytes, rows top to bottom
+ * @param count number of indexes written to plane
+ *
+ * @return  true on success
+ */
+bool LzwDecoder::decode_region(GifImgData * img, const struct region_t & region, uint8_t * plane,
+		size_t & count) {
+	count = 0;
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	if (img->compressed.empty()) {
+		err() << "Missing image data!\n";
+		return false;
+	}
+
+	unsigned min_size = img->compressed[0];
+	if (min_size < 1 || min_size >= kMaxCodeSize) {
+		err() << "Wrong LZW minimum code size " << min_size << "!\n";
+		return false;
+	}
+
+	m_width = img->image_desc.width;
+	m_height = img->image_desc.height;
+	m_interlace = img->has_interlace();
+	m_plane = plane;
+	m_region = region;
+	m_rows_left = (region.width && region.height) ? region.height : 0;
+	m_column = m_row = m_rows_done = 0;
+	m_pass = 0;
+	m_written = 0;
+
+	const unsigned clear = 1 << min_size;
+	const unsigned eoi = clear + 1;
+	for (unsigned i = 0; i < clear; ++i) {
+		m_suffix[i] = m_first[i] = i;
+		m_prefix[i] = 0;
+		m_length[i] = 1;
+	}
+
+	BitReader bits(&img->compressed[1], img->compressed.size() - 1);
+	unsigned next = clear + 2;
+	unsigned width = min_size + 1;
+	unsigned code;
+	int prev = -1;
+	uint64_t codes = 0;
+	uint64_t mark = 0;
+
+	while (m_rows_left) {
+		if (! bits.read(width, code)) {
+			warn_repeated("Missing End Of Image code!\n");
+			break;
+		}
+		codes++;
+
+		if (code == clear) {
+			m_stats.widths[width] += codes - mark;
+			m_stats.clears++;
+			mark = codes;
+			next = clear + 2;
+			width = min_size + 1;
+			prev = -1;
+			continue;
+		}
+
+		if (code == eoi)
+			break;
+
+		if (prev < 0) {
+			if (code >= clear) {
+				warn_repeated(kMsgBadCode);
+				break;
+			}
+			emit_region(code, 1, NULL);
+			prev = code;
+			continue;
+		}
+
+		uint8_t first;
+		if (code < next) {
+			emit_region(code, m_length[code], NULL);
+			first = m_first[code];
+		} else {
+			if (code != next)
+				warn_repeated(kMsgBadCode);
+			first = m_first[prev];
+			emit_region(prev, m_length[prev], NULL);
+			emit_region(0, 1, &first);
+		}
+
+		if (next < kMaxCodes) {
+			m_prefix[next] = prev;
+			m_suffix[next] = first;
+			m_first[next] = m_first[prev];
+			m_length[next] = m_length[prev] + 1;
+			if (code >= next)
+				code = next;
+			next++;
+			if (next == (1U << width) && width < kMaxCodeSize) {
+				m_stats.widths[width] += codes - mark;
+				mark = codes;
+				width++;
+			}
+		}
+
+		prev = code;
+	}
+
+	m_stats.widths[width] += codes - mark;
+	m_stats.codes = codes;
+
+	/*
+	 * Rows of interlaced image are not contiguous, clear the missing ones
+	 */
+	if (m_interlace) {
+		while (m_rows_left) {
+			if (m_row >= m_region.top && m_row < m_region.top + m_region.height) {
+				size_t a = std::max(m_column, m_region.left);
+				size_t b = m_region.left + m_region.width;
+				if (a < b)
+					memset(m_plane + (m_row - m_region.top) * m_region.width + a - m_region.left,
+							0, b - a);
+			}
+			next_region_row();
+		}
+		m_written = region.width * region.height;
+	}
+
+	count = m_written;
+	return true;
+}
+
+/**
+ * @brief  Check image data without decoding it
+ *
+ * Only lengths of dictionary strings are tracked, so codes are validated and
+ * output is measured without building strings or writing pixels. Unlike
+ * decode(), nothing is repaired and the first wrong code stops the check.
+ *
+ * @param img image to check
+ * @param result what is wrong, length of output
+ *
+ * @return  true when the stream is valid
+ */
+bool LzwDecoder::check(const GifImgData * img, struct lzw_check_t & result) {
+	memset(&result, 0, sizeof(result));
+
+	if (img->compressed.empty()) {
+		result.error = lzw_check_t::kNoData;
+		return false;
+	}
+
+	unsigned min_size = img->compressed[0];
+	if (min_size < 1 || min_size >= kMaxCodeSize) {
+		result.error = lzw_check_t::kMinCodeSize;
+		result.code = min_size;
+		return false;
+	}
+
+	const unsigned clear = 1 << min_size;
+	const unsigned eoi = clear + 1;
+	for (unsigned i = 0; i < clear; ++i)
+		m_length[i] = 1;
+
+	BitReader bits(&img->compressed[1], img->compressed.size() - 1);
+	unsigned next = clear + 2;
+	unsigned width = min_size + 1;
+	unsigned code;
+	int prev = -1;
+	uint64_t codes = 0;
+	uint64_t pixels = 0;
+
+	for (;;) {
+		if (! bits.read(width, code)) {
+			result.error = lzw_check_t::kNoEnd;
+			break;
+		}
+		codes++;
+
+		if (code == clear) {
+			next = clear + 2;
+			width = min_size + 1;
+			prev = -1;
+			continue;
+		}
+
+		if (code == eoi)
+			break;
+
+		if ((prev < 0 && code >= clear) || code > next) {
+			result.error = lzw_check_t::kBadCode;
+			result.code = code;
+			result.next = next;
+			break;
+		}
+
+		if (prev < 0) {
+			pixels++;
+			prev = code;
+			continue;
+		}
+
+		if (next < kMaxCodes) {
+			m_length[next] = m_length[prev] + 1;
+			next++;
+			if (next == (1U << width) && width < kMaxCodeSize)
+				width++;
+		}
+
+		pixels += m_length[code];
+		prev = code;
+	}
+
+	result.codes = codes;
+	result.pixels = pixels;
+	return result.error == lzw_check_t::kOk;
+}
+
+/*
+ * Strips of image encoded in parallel are not smaller, shorter ones would
+ * cost more in restarted dictionaries than they save
+ */
+static const size_t kMinStripPixels = 1 << 18;
+
+/**
+ * @brief  Append bits written by another writer
+ *
+ * @param data bytes of the other writer, flushed
+ * @param bits number of bits in data
+ */
+void BitWriter::append(const std::vector<uint8_t> & data, uint64_t bits) {
+	size_t bytes = bits / 8;
+
+	if (m_count == 0) {
+		m_out.insert(m_out.end(), data.begin(), data.begin() + bytes);
+	} else {
+		for (size_t i = 0; i < bytes; ++i)
+			write(data[i], 8);
+	}
+
+	if (bits % 8)
+		write(data[bytes] & ((1U << (bits % 8)) - 1), bits % 8);
+}
+
+/**
+ * @brief  Write bits not written yet, last byte is padded by zeros
+ */
+void BitWriter::flush() {
+	while (m_count > 0) {
+		m_out.push_back((uint8_t) m_bits);
+		m_bits >>= 8;
+		m_count = m_count > 8 ? m_count - 8 : 0;
+	}
+	m_bits = 0;
+}
+
+LzwEncoder::LzwEncoder() : m_generation(0) {
+	memset(m_keys, 0, sizeof(m_keys));
+}
+
+/**
+ * @brief  Start new dictionary, only roots are in it
+ */
+void LzwEncoder::clear() {
+	/*
+	 * Generation takes bits above 20 bit keys
+	 */
+	m_generation += 1 << 20;
+	if (m_generation == 0) {
+		memset(m_keys, 0, sizeof(m_keys));
+		m_generation = 1 << 20;
+	}
+}
+
+/**
+ * @brief  Encode indexes to LZW codes
+ *
+ * Encoding starts with empty dictionary, as after Clear Code, which is not
+ * written. Neither is End Of Image code, so that independently encoded parts
+ * can be joined by Clear Codes.
+ *
+ * @param indexes indexes to color table, all below 1 << min_size
+ * @param count number of indexes
+ * @param min_size LZW minimum code size
+ * @param bits output of codes
+ *
+ * @return  width of code which follows the written ones
+ */
+unsigned LzwEncoder::encode(const uint8_t * indexes, size_t count, unsigned min_size,
+		BitWriter & bits) {
+	const unsigned clear_code = 1 << min_size;
+	unsigned next = clear_code + 2;
+	unsigned width = min_size + 1;
+
+	if (count == 0)
+		return width;
+
+	clear();
+
+	unsigned prefix = indexes[0];
+	for (size_t i = 1; i < count; ++i) {
+		const uint32_t key = (prefix << 8) | indexes[i];
+		uint32_t h = (key * 0x9E3779B1U) >> (32 - kHashBits);
+		bool found = false;
+
+		while ((m_keys[h] & 0xFFF00000U) == m_generation) {
+			if (m_keys[h] == (m_generation | key)) {
+				found = true;
+				break;
+			}
+			h = (h + 1) & (kHashSize - 1);
+		}
+
+		if (found) {
+			prefix = m_codes[h];
+			continue;
+		}
+
+		bits.write(prefix, width);
+
+		if (next < LzwDecoder::kMaxCodes) {
+			/*
+			 * Decoder adds the entry a code later, it widens codes when
+			 * the entry before this one reaches next power of two
+			 */
+			m_keys[h] = m_generation | key;
+			m_codes[h] = next++;
+			if (next > (1U << width) && width < LzwDecoder::kMaxCodeSize)
+				width++;
+		} else {
+			bits.write(clear_code, width);
+			next = clear_code + 2;
+			width = min_size + 1;
+			clear();
+		}
+
+		prefix = indexes[i];
+	}
+
+	bits.write(prefix, width);
+
+	/*
+	 * Decoder adds the entry of last code too
+	 */
+	if (next == (1U << width) && width < LzwDecoder::kMaxCodeSize)
+		width++;
+	return width;
+}
+
+/**
+ * @brief  Encoded strip of image
+ */
+struct lzw_strip_t {
+	const uint8_t * indexes;
+	size_t count;
+	std::vector<uint8_t> data;
+	uint64_t bits;
+	unsigned width;				///< Width of code after the strip
+};
+
+/**
+ * @brief  Encode strip to its own buffer
+ */
+static void encode_strip(struct lzw_strip_t * strip, unsigned min_size) {
+	LzwEncoder * encoder = new LzwEncoder;
+	BitWriter bits(strip->data);
+
+	strip->data.reserve(strip->count / 2);
+	strip->width = encoder->encode(strip->indexes, strip->count, min_size, bits);
+	strip->bits = bits.bits();
+	bits.flush();
+	delete encoder;
+}
+
+/**
+ * @brief  Encode image data as stored in GIF (without sub-blocks)
+ *
+ * Large images are split to strips of pixels encoded in parallel. Strips are
+ * joined by Clear Codes, so a decoder sees one stream.
+ *
+ * @param indexes indexes to color table, rows top to bottom
+ * @param count number of indexes
+ * @param min_size LZW minimum code size, all indexes are below 1 << min_size
+ * @param out output, LZW minimum code size byte followed by codes
+ * @param threads maximal number of strips encoded at once, 0 for number of
+ * CPUs
+ * @param strips number of strips image was split to, may be NULL
+ *
+ * @return  true on success
+ */
+bool lzw_encode(const uint8_t * indexes, size_t count, unsigned min_size,
+		std::vector<uint8_t> & out, unsigned threads, unsigned * strips) {
+	if (min_size < 2 || min_size >= LzwDecoder::kMaxCodeSize) {
+		err() << "Wrong LZW minimum code size " << min_size << "!\n";
+		return false;
+	}
+
+	size_t n = std::max(count / kMinStripPixels, (size_t) 1);
+	if (n > 1 && threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1U);
+	n = std::min(n, (size_t) std::max(threads, 1U));
+	std::vector<struct lzw_strip_t> parts(n);
+	for (size_t i = 0; i < n; ++i) {
+		parts[i].indexes = indexes + count * i / n;
+		parts[i].count = count * (i + 1) / n - count * i / n;
+	}
+
+	if (n == 1) {
+		encode_strip(&parts[0], min_size);
+	} else {
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < n; ++i)
+			workers.push_back(std::thread(encode_strip, &parts[i], min_size));
+		for (size_t i = 0; i < n; ++i)
+			workers[i].join();
+	}
+
+	const unsigned clear_code = 1 << min_size;
+	size_t size = 0;
+	for (size_t i = 0; i < n; ++i)
+		size += parts[i].data.size();
+
+	out.clear();
+	out.reserve(size + n * 4 + 8);
+	out.push_back(min_size);
+
+	BitWriter bits(out);
+	bits.write(clear_code, min_size + 1);
+	for (size_t i = 0; i < n; ++i) {
+		bits.append(parts[i].data, parts[i].bits);
+		bits.write(i + 1 < n ? clear_code : clear_code + 1, parts[i].width);
+	}
+	bits.flush();
+
+	if (strips)
+		*strips = n;
+	return true;
+}
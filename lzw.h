@@ -0,0 +1,274 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 10:05:31 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef LZW_H_
+#define LZW_H_
+
+#include <inttypes.h>
+#include <cstddef>
+
+#include <vector>
+
+class GifImgData;
+
+/**
+ * @brief  Counters of one decoded image
+ */
+struct lzw_stats_t {
+	uint64_t codes;			///< Codes read, including Clear Code and End Of Image
+	uint64_t clears;			///< Clear Codes
+	uint64_t widths[13];		///< Codes read with given width (up to 12 bits)
+};
+
+/**
+ * @brief  Rectangle of image or screen in pixels
+ */
+struct region_t {
+	size_t left;
+	size_t top;
+	size_t width;
+	size_t height;
+};
+
+/**
+ * @brief  Result of checking image data without decoding it
+ */
+struct lzw_check_t {
+	enum error_t {
+		kOk,
+		kNoData,					///< Image has no data
+		kMinCodeSize,			///< Wrong LZW minimum code size
+		kBadCode,				///< Code is not in dictionary
+		kNoEnd					///< Data end before End Of Image code
+	} error;
+	uint64_t codes;			///< Codes read, up to the wrong one on error
+	unsigned code;				///< Wrong code
+	unsigned next;				///< Next code to be added to dictionary
+	uint64_t pixels;			///< Length of output, pixels past the image included
+};
+
+/**
+ * @brief  Called by LzwDecoder::decode() when a pass of interlaced image is
+ * complete, rows of later passes are filled by the nearest decoded row
+ *
+ * @param pass complete pass, counted from 0
+ * @param plane whole image, rows top to bottom
+ * @param arg argument given with the listener
+ */
+typedef void (*lzw_pass_fn)(unsigned pass, const uint8_t * plane, void * arg);
+
+/**
+ * @brief  Reads variable width codes from GIF data, least significant bit first
+ */
+class BitReader {
+public:
+	BitReader(const uint8_t * data, size_t size)
+		: m_pos(data), m_end(data + size), m_bits(0), m_count(0) { }
+
+	/**
+	 * @brief  Read a code
+	 *
+	 * @param width width of the code in bits
+	 * @param code output code, missing bits at the end of data are zero
+	 *
+	 * @return  false when there are no more bits
+	 */
+	bool read(unsigned width, unsigned & code) {
+		if (m_count < width) {
+			while (m_count <= 56 && m_pos < m_end) {
+				m_bits |= (uint64_t) *m_pos++ << m_count;
+				m_count += 8;
+			}
+			if (m_count == 0)
+				return false;
+			if (m_count < width)
+				m_count = width;
+		}
+
+		code = m_bits & ((1U << width) - 1);
+		m_bits >>= width;
+		m_count -= width;
+		return true;
+	}
+
+	/**
+	 * @brief  Number of bytes not consumed yet
+	 */
+	size_t left() const { return m_end - m_pos; }
+
+private:
+	const uint8_t * m_pos;
+	const uint8_t * m_end;
+	uint64_t m_bits;
+	unsigned m_count;
+}; // class BitReader
+
+/**
+ * @brief  Writes variable width codes of GIF data, least significant bit
+ * first
+ */
+class BitWriter {
+public:
+	BitWriter(std::vector<uint8_t> & out) : m_out(out), m_bits(0), m_count(0) { }
+
+	/**
+	 * @brief  Write a code
+	 *
+	 * @param code code to write, it has to fit to width
+	 * @param width width of the code in bits
+	 */
+	void write(unsigned code, unsigned width) {
+		m_bits |= (uint64_t) code << m_count;
+		m_count += width;
+		if (m_count >= 32) {
+			const uint8_t bytes[4] = {
+				(uint8_t) m_bits, (uint8_t) (m_bits >> 8),
+				(uint8_t) (m_bits >> 16), (uint8_t) (m_bits >> 24)
+			};
+			m_out.insert(m_out.end(), bytes, bytes + 4);
+			m_bits >>= 32;
+			m_count -= 32;
+		}
+	}
+
+	void append(const std::vector<uint8_t> & data, uint64_t bits);
+	void flush();
+
+	/**
+	 * @brief  Number of bits written, including those not flushed yet
+	 */
+	uint64_t bits() const { return 8 * (uint64_t) m_out.size() + m_count; }
+
+private:
+	std::vector<uint8_t> & m_out;
+	uint64_t m_bits;
+	unsigned m_count;
+}; // class BitWriter
+
+/**
+ * @brief  GIF LZW encoder
+ *
+ * Dictionary is an open addressing hash table of (prefix code, byte) keys.
+ * Entries are tagged by generation, so Clear Code does not have to wipe it.
+ */
+class LzwEncoder {
+public:
+	LzwEncoder();
+
+	unsigned encode(const uint8_t * indexes, size_t count, unsigned min_size, BitWriter & bits);
+
+	static const unsigned kHashBits = 14;
+	static const unsigned kHashSize = 1 << kHashBits;
+
+private:
+	void clear();
+
+	uint32_t m_keys[kHashSize];		///< Generation and key, 0 when never used
+	uint16_t m_codes[kHashSize];		///< Code of string of key
+	uint32_t m_generation;				///< Generation of current dictionary
+}; // class LzwEncoder
+
+bool lzw_encode(const uint8_t * indexes, size_t count, unsigned min_size,
+		std::vector<uint8_t> & out, unsigned threads = 0, unsigned * strips = NULL);
+
+/**
+ * @brief  GIF LZW decoder
+ *
+ * Dictionary is kept as prefix/suffix tables of fixed size, so an instance
+ * does not allocate and can be reused for any number of images.
+ */
+class LzwDecoder {
+public:
+	LzwDecoder();
+
+	bool decode(GifImgData * img, uint8_t * plane, size_t & count);
+	bool start(GifImgData * img, uint8_t * plane);
+	bool step(size_t max_codes);
+	bool decode_region(GifImgData * img, const struct region_t & region, uint8_t * plane,
+			size_t & count);
+	bool check(const GifImgData * img, struct lzw_check_t & result);
+	void set_pass_listener(lzw_pass_fn fn, void * arg, unsigned passes);
+
+	/**
+	 * @brief  Counters of last decoded image
+	 */
+	const struct lzw_stats_t & stats() const { return m_stats; }
+
+	/**
+	 * @brief  Number of indexes written by decoding started by start()
+	 */
+	size_t count() const { return m_written; }
+
+	/**
+	 * @brief  Whether step() finished the image (or it was not started)
+	 */
+	bool done() const { return m_done; }
+
+	static const unsigned kMaxCodes = 4096;
+	static const unsigned kMaxCodeSize = 12;
+	static const size_t kAllCodes = (size_t) -1;		///< step() budget to decode the whole image
+
+private:
+	void emit(const uint8_t * str, size_t len);
+	void emit_code(unsigned code);
+	void next_row();
+	void pass_done(unsigned pass);
+	void emit_region(unsigned code, size_t len, const uint8_t * str);
+	void next_region_row();
+
+	uint16_t m_prefix[kMaxCodes];		///< Code of string without last byte
+	uint16_t m_length[kMaxCodes];		///< Length of string
+	uint8_t m_suffix[kMaxCodes];		///< Last byte of string
+	uint8_t m_first[kMaxCodes];		///< First byte of string
+	uint8_t m_stack[kMaxCodes];		///< String being output
+	struct lzw_stats_t m_stats;
+
+	/*
+	 * Output position
+	 */
+	uint8_t * m_plane;
+	uint8_t * m_out;
+	size_t m_row_left;
+	size_t m_width;
+	size_t m_height;
+	size_t m_row;
+	size_t m_rows_done;
+	size_t m_written;
+	unsigned m_pass;
+	bool m_interlace;
+
+	/*
+	 * Listener of passes of interlaced image, only decode() calls it
+	 */
+	lzw_pass_fn m_pass_fn;
+	void * m_pass_arg;
+	unsigned m_pass_limit;			///< Passes reported, counted from 0
+
+	/*
+	 * Decoding state kept between step() calls
+	 */
+	BitReader m_bits;
+	unsigned m_min_size;
+	unsigned m_next;					///< Next code to be added to dictionary
+	unsigned m_code_width;
+	int m_prev;							///< Previous code, -1 after Clear Code
+	uint64_t m_codes;					///< Codes read so far
+	uint64_t m_mark;					///< Codes when width histogram was updated
+	bool m_done;
+
+	/*
+	 * Output position of decode_region(), row is m_row
+	 */
+	struct region_t m_region;
+	size_t m_column;
+	size_t m_rows_left;			///< Rows of region not complete yet
+}; // class LzwDecoder
+
+#endif // LZW_H_
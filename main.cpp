@@ -14,12 +14,26 @@
 #include <fstream>
 #include <getopt.h>
 #include <cassert>
+#include <climits>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
 #include "gif2bmp.h"
+#include "server.h"
+#include "watch.h"
+#include "cache.h"
+#include "trace.h"
+#include "probe.h"
+#include "frames.h"
+#include "bmp2gif.h"
 #include "common.h"
 
+const size_t kTarBufferSize		= 1 << 20;
+const uint64_t kMaxWorkers		= 1024;
+const uint64_t kMaxThreads		= 1024;
+const uint64_t kMaxQueueSize	= 65536;
+const uint64_t kMaxCacheSize	= SIZE_MAX >> 20;
+const uint64_t kMaxReportInterval	= 24 * 3600;
 
 /**
  * @brief  Program description and author
@@ -38,8 +52,100 @@ static const char * MSG_USAGE =
 	"\t-l FILE\t\t- use FILE as log file\n"
 	"\t-e\t\t- extract all images from GIF, cannot be used with -o\n"
 	"\t\t\timages are saved as 0001.bmp, 0002.bmp...\n"
+	"\t-q\t\t- print errors only, same as --log-level error\n"
+	"\t--log-level L\t- print messages up to level L: quiet, error, warning\n"
+	"\t\t\tor info (default)\n"
+	"\t--serve SOCKET\t- run conversion server on unix socket SOCKET\n"
+	"\t--watch DIR\t- convert GIFs closed or moved to DIR (Linux inotify) to BMPs\n"
+	"\t\t\tin --out DIR, inputs are moved to DIR/done or DIR/failed\n"
+	"\t--out DIR\t- directory for BMPs of --watch\n"
+	"\t--report S\t- with --watch, log queue depth and latency every S seconds\n"
+	"\t\t\t(default 10)\n"
+	"\t--workers N\t- number of server or watch worker threads (default 4)\n"
+	"\t--queue N\t- max connections or files waiting for a worker (default 64)\n"
+	"\t--cache-size MB\t- keep up to MB of converted images in server memory\n"
+	"\t--cache-dir DIR\t- reuse converted images stored in DIR\n"
+	"\t--max-pixels N\t- reject GIF whose screen or an image has more than N pixels\n"
+	"\t--max-frames N\t- reject GIF with more than N images\n"
+	"\t--max-decoded N\t- reject GIF whose images have more than N pixels in total\n"
+	"\t--memory MB\t- memory budget of conversions, with --serve conversions\n"
+	"\t\t\twait until others running return enough of it\n"
+	"\t--scale N\t- write images downscaled N times (box filter)\n"
+	"\t--max-dim N\t- downscale images so that no side is longer than N\n"
+	"\t--crop X,Y,W,H\t- write only WxH region of screen at X,Y, only image data\n"
+	"\t\t\tup to its last row are decoded\n"
+	"\t--preview FILE\t- for interlaced GIF, write preview BMP to FILE as soon as\n"
+	"\t\t\tfirst pass is decoded, missing rows are copied from\n"
+	"\t\t\tthe nearest decoded one\n"
+	"\t--preview-passes N - replace preview after each of first N passes\n"
+	"\t\t\t(1 or 2, default 1)\n"
+	"\t--frame N\t- convert frame N (counted from 1) as displayed, composited\n"
+	"\t\t\twith preceding frames; ranges like 2-5,8,10- can be used\n"
+	"\t\t\twith -e\n"
+	"\t--writer MODE\t- with -e, write files in background while decoding:\n"
+	"\t\t\turing (threads when io_uring is not available), threads\n"
+	"\t\t\tor sync (default)\n"
+	"\t--dedup\t\t- with -e, link images identical to an earlier one instead\n"
+	"\t\t\tof writing them again\n"
+	"\t--tar FILE\t- with -e, write images to uncompressed tar FILE instead of\n"
+	"\t\t\tseparate files\n"
+	"\t--index FILE\t- with --frame, keep frame offsets of input in FILE so that\n"
+	"\t\t\tnext runs do not have to scan the whole GIF\n"
+	"\t--info\t\t- print dimensions, frames, delays, loop count and color\n"
+	"\t\t\ttable sizes as JSON, images are not decoded\n"
+	"\t--hash\t\t- decode only and print XXH64 of pixels of every image and\n"
+	"\t\t\tof all images, no BMP is written\n"
+	"\t--verify\t- check GIF structure and image data without decoding pixels,\n"
+	"\t\t\tprint errors as JSON, exit status is 1 for broken GIF\n"
+	"\t--stream\t- input is GIFs one after another (e.g. a pipe), each is\n"
+	"\t\t\tconverted as soon as it is read; output gets \"OK <size>\\n\"\n"
+	"\t\t\tand BMP or \"ERR <reason>\\n\" per GIF, with -e BMPs go to\n"
+	"\t\t\t0001.bmp, 0002.bmp, ... instead\n"
+	"\t--bmp2gif\t- convert BMP (1, 4, 8, 24 or 32 bits) to GIF instead, more\n"
+	"\t\t\tthan 256 colors are reduced by median cut\n"
+	"\t--threads N\t- with --bmp2gif, encode up to N strips of image at once\n"
+	"\t\t\t(default number of CPUs)\n"
+	"\t--trace FILE\t- write timeline of conversion to FILE (Chrome trace JSON),\n"
+	"\t\t\tneeds build with 'make TRACE=1'\n"
 	"\t-h FILE\t\t-print this simple help";
 
+/**
+ * @brief  Long options, short options are handled by getopt() string
+ */
+static const struct option LONG_OPTS[] = {
+	{ "serve",		required_argument,	NULL,	'S' },
+	{ "watch",		required_argument,	NULL,	'E' },
+	{ "out",			required_argument,	NULL,	'd' },
+	{ "report",		required_argument,	NULL,	'r' },
+	{ "workers",	required_argument,	NULL,	'W' },
+	{ "queue",		required_argument,	NULL,	'Q' },
+	{ "cache-size",	required_argument,	NULL,	'C' },
+	{ "cache-dir",	required_argument,	NULL,	'D' },
+	{ "trace",		required_argument,	NULL,	'T' },
+	{ "log-level",	required_argument,	NULL,	'L' },
+	{ "info",		no_argument,			NULL,	'I' },
+	{ "frame",		required_argument,	NULL,	'F' },
+	{ "index",		required_argument,	NULL,	'X' },
+	{ "tar",			required_argument,	NULL,	'A' },
+	{ "writer",		required_argument,	NULL,	'B' },
+	{ "dedup",		no_argument,			NULL,	'U' },
+	{ "hash",			no_argument,			NULL,	'H' },
+	{ "verify",		no_argument,			NULL,	'V' },
+	{ "max-pixels",	required_argument,	NULL,	'P' },
+	{ "max-frames",	required_argument,	NULL,	'N' },
+	{ "max-decoded",	required_argument,	NULL,	'K' },
+	{ "memory",		required_argument,	NULL,	'M' },
+	{ "scale",		required_argument,	NULL,	'G' },
+	{ "max-dim",		required_argument,	NULL,	'Y' },
+	{ "crop",			required_argument,	NULL,	'R' },
+	{ "preview",		required_argument,	NULL,	'p' },
+	{ "preview-passes",	required_argument,	NULL,	'n' },
+	{ "bmp2gif",		no_argument,			NULL,	'Z' },
+	{ "stream",		no_argument,			NULL,	'O' },
+	{ "threads",		required_argument,	NULL,	'J' },
+	{ NULL,			0,							NULL,	0 }
+};
+
 /**
  * @brief  Clean up opened files
  *
@@ -54,6 +160,20 @@ void clean_up(FILE * in_file, FILE * out_file, FILE * log_file) {
 	if (log_file)									fclose(log_file);
 }
 
+/**
+ * @brief  Parse positive number of option
+ *
+ * @param arg option argument
+ * @param value parsed number
+ *
+ * @return  false when arg is not a positive number
+ */
+static bool parse_limit(const char * arg, uint64_t & value) {
+	char * end = NULL;
+	value = strtoull(arg, &end, 10);
+	return *arg >= '0' && *arg <= '9' && *end == '\0' && value > 0;
+}
+
 /**
  * @brief  Print help
  *
@@ -68,6 +188,9 @@ void print_help(const char * pname) {
 /**
  * @brief  Print conversion statistics
  *
+ * Every line is "key = value", counters which are indexed (by code width or
+ * image) have the index in brackets.
+ *
  * @param log_file log file to print to
  * @param status conversion statistics
  */
@@ -80,6 +203,60 @@ void print_stats(FILE * log_file, struct gif2bmp_t * status) {
 	fputs("login = xlogin00\n", log_file);
 	fprintf(log_file, "uncodedSize = %" PRId64 "\n", status->bmp_size);
 	fprintf(log_file, "codedSize = %" PRId64 "\n", status->gif_size);
+
+	for (size_t i = 0; i < kStageCount; ++i) {
+		fprintf(log_file, "%sWallUs = %" PRIu64 "\n", kStageNames[i], status->stages[i].wall_us);
+		fprintf(log_file, "%sCpuUs = %" PRIu64 "\n", kStageNames[i], status->stages[i].cpu_us);
+	}
+
+	fprintf(log_file, "parsedBytes = %" PRIu64 "\n", status->parse.bytes);
+	fprintf(log_file, "subBlocks = %" PRIu64 "\n", status->parse.sub_blocks);
+	fprintf(log_file, "codes = %" PRIu64 "\n", status->lzw.codes);
+	fprintf(log_file, "clearCodes = %" PRIu64 "\n", status->lzw.clears);
+	for (size_t i = 0; i < sizeof(status->lzw.widths) / sizeof(status->lzw.widths[0]); ++i)
+		if (status->lzw.widths[i])
+			fprintf(log_file, "codeWidth[%zu] = %" PRIu64 "\n", i, status->lzw.widths[i]);
+
+	fprintf(log_file, "frames = %" PRIu64 "\n", status->frames);
+	fprintf(log_file, "dedupFrames = %" PRIu64 "\n", status->dedup_frames);
+	fprintf(log_file, "dedupBytes = %" PRIu64 "\n", status->dedup_bytes);
+	if (status->frame_pixels)
+		for (size_t i = 0; i < status->frame_pixels->size(); ++i)
+			fprintf(log_file, "framePixels[%zu] = %" PRIu64 "\n", i, (*status->frame_pixels)[i]);
+	fprintf(log_file, "allocs = %" PRIu64 "\n", status->allocs);
+}
+
+/**
+ * @brief  Print statistics of BMP to GIF conversion, same format as
+ * print_stats()
+ *
+ * @param log_file log file to print to
+ * @param status conversion statistics
+ */
+void print_encode_stats(FILE * log_file, struct bmp2gif_t * status) {
+	assert(status);
+
+	if (! log_file)
+		return;
+
+	const struct { const char * name; const struct stage_time_t * time; } stages[] = {
+		{ "read", &status->read }, { "quantize", &status->quantize },
+		{ "encode", &status->encode }, { "write", &status->write }
+	};
+
+	fputs("login = xlogin00\n", log_file);
+	fprintf(log_file, "uncodedSize = %" PRId64 "\n", status->bmp_size);
+	fprintf(log_file, "codedSize = %" PRId64 "\n", status->gif_size);
+
+	for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); ++i) {
+		fprintf(log_file, "%sWallUs = %" PRIu64 "\n", stages[i].name, stages[i].time->wall_us);
+		fprintf(log_file, "%sCpuUs = %" PRIu64 "\n", stages[i].name, stages[i].time->cpu_us);
+	}
+
+	fprintf(log_file, "pixels = %" PRIu64 "\n", status->pixels);
+	fprintf(log_file, "colors = %u\n", status->colors);
+	fprintf(log_file, "quantized = %d\n", status->quantized ? 1 : 0);
+	fprintf(log_file, "strips = %u\n", status->strips);
 }
 
 /**
@@ -94,11 +271,36 @@ int main(int argc, char * argv[]) {
 	FILE * in_file  = stdin;
 	FILE * out_file = stdout;
 	FILE * log_file = NULL;
-	struct gif2bmp_t status;
+	struct gif2bmp_t status = gif2bmp_t();
+	std::vector<uint64_t> frame_pixels;
+	const char * trace_path = NULL;
+	int log_level = kLogInfo;
+	bool probe = false;
+	std::vector<struct frame_range_t> frames;
+	const char * index_path = NULL;
+	const char * tar_path = NULL;
+	FILE * tar_file = NULL;
+	AsyncWriter::backend_t backend = AsyncWriter::kBackendSync;
+	AsyncWriter * writer = NULL;
+	bool dedup = false;
+	bool hash = false;
+	bool verify = false;
+	struct serve_opts_t serve_opts = { NULL, 4, 64, 0, NULL };
+	struct watch_opts_t watch_opts = { NULL, NULL, 4, 64, 10, NULL };
+	struct limits_t limits = { 0, 0, 0, 0 };
+	unsigned scale = 0;
+	unsigned max_dim = 0;
+	struct region_t crop;
+	bool cropped = false;
+	const char * preview = NULL;
+	unsigned preview_passes = 1;
+	bool encode = false;
+	bool stream = false;
+	unsigned threads = 0;
 	int res = EXIT_SUCCESS;
 
 	 int c;
-	 while ((c = getopt(argc, argv, "i:o:l:he")) != -1) {
+	 while ((c = getopt_long(argc, argv, "i:o:l:heq", LONG_OPTS, NULL)) != -1) {
 		 switch (c) {
 			case 'i':
 				in_file = fopen(optarg, "rb");
@@ -135,6 +337,195 @@ int main(int argc, char * argv[]) {
 					return EXIT_FAILURE;
 				}
 				break;
+			case 'S':
+				serve_opts.socket_path = optarg;
+				break;
+			case 'E':
+				watch_opts.dir = optarg;
+				break;
+			case 'd':
+				watch_opts.out_dir = optarg;
+				break;
+			case 'r': {
+				char * end = NULL;
+				uint64_t value = strtoull(optarg, &end, 10);
+				if (*optarg < '0' || *optarg > '9' || *end != '\0' || value > kMaxReportInterval) {
+					err() << "Report interval has to be a number of seconds up to "
+							<< kMaxReportInterval << "!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				watch_opts.report_interval = value;
+				break;
+			}
+			case 'W': {
+				uint64_t workers = 0;
+				if (! parse_limit(optarg, workers) || workers > kMaxWorkers) {
+					err() << "Number of workers has to be between 1 and " << kMaxWorkers << "!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				serve_opts.workers = workers;
+				break;
+			}
+			case 'Q': {
+				uint64_t queue_size = 0;
+				if (! parse_limit(optarg, queue_size) || queue_size > kMaxQueueSize) {
+					err() << "Queue size has to be between 1 and " << kMaxQueueSize << "!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				serve_opts.queue_size = queue_size;
+				break;
+			}
+			case 'C': {
+				uint64_t cache_size = 0;
+				if (! parse_limit(optarg, cache_size) || cache_size > kMaxCacheSize) {
+					err() << "Cache size has to be a positive number of MB!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				serve_opts.cache_size = cache_size << 20;
+				break;
+			}
+			case 'D':
+				serve_opts.cache_dir = optarg;
+				break;
+			case 'T':
+				trace_path = optarg;
+				break;
+			case 'q':
+				log_level = kLogError;
+				break;
+			case 'I':
+				probe = true;
+				break;
+			case 'F':
+				if (! parse_frame_ranges(optarg, frames)) {
+					err() << "Wrong frame selection '" << optarg << "'!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'X':
+				index_path = optarg;
+				break;
+			case 'A':
+				tar_path = optarg;
+				break;
+			case 'U':
+				dedup = true;
+				break;
+			case 'H':
+				hash = true;
+				break;
+			case 'V':
+				verify = true;
+				break;
+			case 'Z':
+				encode = true;
+				break;
+			case 'O':
+				stream = true;
+				break;
+			case 'J': {
+				uint64_t value = 0;
+				if (! parse_limit(optarg, value) || value > kMaxThreads) {
+					err() << "Number of threads has to be between 1 and " << kMaxThreads << "!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				threads = value;
+				break;
+			}
+			case 'P':
+				if (! parse_limit(optarg, limits.max_pixels)) {
+					err() << "Limit has to be a positive number!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'N':
+				if (! parse_limit(optarg, limits.max_frames)) {
+					err() << "Limit has to be a positive number!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'K':
+				if (! parse_limit(optarg, limits.max_decoded)) {
+					err() << "Limit has to be a positive number!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'M':
+				if (! parse_limit(optarg, limits.memory)) {
+					err() << "Limit has to be a positive number!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				limits.memory <<= 20;
+				break;
+			case 'G': {
+				uint64_t value = 0;
+				if (! parse_limit(optarg, value) || value > UINT_MAX) {
+					err() << "Scale has to be a positive number!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				scale = value;
+				break;
+			}
+			case 'Y': {
+				uint64_t value = 0;
+				if (! parse_limit(optarg, value) || value > UINT_MAX) {
+					err() << "Maximal dimension has to be a positive number!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				max_dim = value;
+				break;
+			}
+			case 'R': {
+				int end = 0;
+				cropped = sscanf(optarg, "%zu,%zu,%zu,%zu%n", &crop.left, &crop.top,
+						&crop.width, &crop.height, &end) == 4 && optarg[end] == '\0'
+						&& crop.width && crop.height;
+				if (! cropped) {
+					err() << "Crop region has to be X,Y,W,H with positive W and H!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				break;
+			}
+			case 'p':
+				preview = optarg;
+				break;
+			case 'n': {
+				uint64_t value = 0;
+				if (! parse_limit(optarg, value) || value > 2) {
+					err() << "Preview can be written after 1 or 2 passes!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				preview_passes = value;
+				break;
+			}
+			case 'B':
+				if (! AsyncWriter::parse_backend(optarg, backend)) {
+					err() << "Unknown writer '" << optarg << "'!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'L':
+				if (! log_parse_level(optarg, log_level)) {
+					err() << "Unknown log level '" << optarg << "'!\n";
+					clean_up(in_file, out_file, log_file);
+					return EXIT_FAILURE;
+				}
+				break;
 			case 'h':
 				print_help(argv[0]);
 				clean_up(in_file, out_file, log_file);
@@ -154,21 +545,192 @@ int main(int argc, char * argv[]) {
 		res = EXIT_FAILURE;
 	}
 
+	if (log_file)
+		status.frame_pixels = &frame_pixels;
+
 	/*
 	 * Just do it!
 	 */
 	if (res != EXIT_SUCCESS) {
 		clean_up(in_file, out_file, log_file);
 		return res;
+	}
+
+	log_init(log_level);
+	limits_init(limits);
+
+	if (trace_path) {
+		if (trace_available())
+			trace_start();
+		else
+			warn() << "Tracing is not compiled in, rebuild with 'make TRACE=1'!\n";
+	}
+
+	/*
+	 * Images go to archive sequentially, in large writes
+	 */
+	if (tar_path) {
+		if (out_file != NULL || probe || hash || verify || serve_opts.socket_path
+				|| serve_opts.cache_dir) {
+			err() << "Option --tar can be used only with -e!\n";
+			clean_up(in_file, out_file, log_file);
+			return EXIT_FAILURE;
+		}
+		tar_file = fopen(tar_path, "wb");
+		if (! tar_file) {
+			clean_up(in_file, out_file, log_file);
+			perror(tar_path);
+			return EXIT_FAILURE;
+		}
+		setvbuf(tar_file, NULL, _IOFBF, kTarBufferSize);
+	}
+	TarWriter tar(tar_file);
+
+	/*
+	 * Separate files are written in background while next images are decoded
+	 */
+	if (backend != AsyncWriter::kBackendSync && out_file == NULL && ! tar_file
+			&& ! probe && ! hash && ! verify && ! serve_opts.socket_path && ! serve_opts.cache_dir)
+		writer = new AsyncWriter(backend);
+	struct gif2bmp_out_t extract_out = { tar_file ? &tar : NULL, writer, dedup, scale, max_dim,
+			cropped ? &crop : NULL, preview, preview_passes };
+
+	if ((scale || max_dim) && (serve_opts.socket_path || serve_opts.cache_dir))
+		warn() << "Server and cache convert full size images, ignoring --scale and --max-dim!\n";
+	if (cropped && (serve_opts.socket_path || serve_opts.cache_dir))
+		warn() << "Server and cache convert whole screen, ignoring --crop!\n";
+
+	if (index_path && frames.empty())
+		warn() << "Frame index is used with --frame only, ignoring --index!\n";
+
+	if (preview && (out_file == NULL || probe || hash || verify || encode || stream
+				|| ! frames.empty() || serve_opts.socket_path || serve_opts.cache_dir
+				|| watch_opts.dir || watch_opts.out_dir)) {
+		err() << "Option --preview can be used only with plain conversion!\n";
+		clean_up(in_file, out_file, log_file);
+		return EXIT_FAILURE;
+	}
+	if (preview && cropped)
+		warn() << "Preview is not written for cropped image, ignoring --preview!\n";
+
+	if (serve_opts.socket_path) {
+		res = serve(&serve_opts);
+	} else if (watch_opts.dir || watch_opts.out_dir) {
+		if (! watch_opts.dir || ! watch_opts.out_dir || in_file != stdin || out_file != stdout
+				|| probe || hash || verify || encode || stream || ! frames.empty()
+				|| tar_file || serve_opts.cache_dir) {
+			err() << "Options --watch and --out go together, with conversion options only!\n";
+			clean_up(in_file, out_file, log_file);
+			return EXIT_FAILURE;
+		}
+
+		struct gif2bmp_out_t watch_out = { NULL, NULL, false, scale, max_dim,
+				cropped ? &crop : NULL, NULL, 0 };
+		watch_opts.workers = serve_opts.workers;
+		watch_opts.queue_size = serve_opts.queue_size;
+		watch_opts.out = &watch_out;
+		res = watch(&watch_opts);
+	} else if (encode) {
+		if (out_file == NULL) {
+			err() << "Cannot use --bmp2gif and -e at the same time!\n";
+			clean_up(in_file, out_file, log_file);
+			return EXIT_FAILURE;
+		}
+
+		struct bmp2gif_t encode_status;
+		res = bmp2gif(&encode_status, in_file, out_file, threads);
+		if (res == 0 && log_file)
+			print_encode_stats(log_file, &encode_status);
+	} else if (stream) {
+		if (probe || hash || verify || encode || ! frames.empty() || serve_opts.cache_dir) {
+			err() << "Option --stream can be used only with plain conversion or -e!\n";
+			clean_up(in_file, out_file, log_file);
+			return EXIT_FAILURE;
+		}
+
+		res = gif2bmp_stream(&status, in_file, out_file, NULL, &extract_out);
+		if (log_file)
+			print_stats(log_file, &status);
+	} else if (probe) {
+		if (out_file == NULL) {
+			err() << "Cannot use --info and -e at the same time!\n";
+			clean_up(in_file, out_file, log_file);
+			return EXIT_FAILURE;
+		}
+
+		struct gif_info_t info;
+		if (gif_probe_file(in_file, &info))
+			gif_info_json(out_file, &info);
+		else
+			res = EXIT_FAILURE;
+	} else if (hash) {
+		if (out_file == NULL) {
+			err() << "Cannot use --hash and -e at the same time!\n";
+			clean_up(in_file, out_file, log_file);
+			return EXIT_FAILURE;
+		}
+
+		res = gif2bmp_hash(&status, in_file, out_file);
+		if (res == 0 && log_file)
+			print_stats(log_file, &status);
+	} else if (verify) {
+		if (out_file == NULL) {
+			err() << "Cannot use --verify and -e at the same time!\n";
+			clean_up(in_file, out_file, log_file);
+			return EXIT_FAILURE;
+		}
+
+		std::vector<struct gif2bmp_error_t> errors;
+		size_t images;
+		res = gif2bmp_verify(&status, in_file, images, errors);
+		gif2bmp_verify_json(out_file, images, errors);
+		if (log_file)
+			print_stats(log_file, &status);
+	} else if (! frames.empty()) {
+		res = gif2bmp_frames(&status, in_file, out_file, frames, NULL, index_path, &extract_out);
+		if (res == 0 && log_file)
+			print_stats(log_file, &status);
+	} else if (serve_opts.cache_dir) {
+		if (out_file == NULL) {
+			err() << "Cannot use --cache-dir and -e at the same time!\n";
+			clean_up(in_file, out_file, log_file);
+			return EXIT_FAILURE;
+		}
+
+		ConvCache cache(0, serve_opts.cache_dir);
+		std::vector<char> data;
+		if (! read_all(in_file, data)) {
+			err() << "Failed to read input!\n";
+			res = EXIT_FAILURE;
+		} else {
+			res = gif2bmp_cached(&cache, &status, data.data(), data.size(), out_file);
+		}
+		if (res == 0 && log_file)
+			print_stats(log_file, &status);
 	} else {
-		res = gif2bmp(&status, in_file, out_file);
+		res = gif2bmp(&status, in_file, out_file, NULL, &extract_out);
 		if (res == 0 && log_file)
 			print_stats(log_file, &status);
-		clean_up(in_file, out_file, log_file);
-		return res;
 	}
 
-	UNREACHABLE();
-	return EXIT_FAILURE;
-}
+	if (tar_file) {
+		if (res == 0 && ! tar.finish())
+			res = EXIT_FAILURE;
+		fclose(tar_file);
+	}
+	delete writer;
+
+	if (trace_path && trace_available()) {
+		FILE * trace_file = fopen(trace_path, "w");
+		if (! trace_file || ! trace_write(trace_file)) {
+			perror(trace_path);
+			res = EXIT_FAILURE;
+		}
+		if (trace_file)
+			fclose(trace_file);
+	}
 
+	log_summary();
+	clean_up(in_file, out_file, log_file);
+	return res;
+}
@@ -0,0 +1,146 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 09:41:53 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "pool.h"
+
+/**
+ * @brief  Per thread count of operator new calls
+ */
+static thread_local uint64_t t_allocs = 0;
+
+/*
+ * Replace global allocation functions to count allocations, the memory still
+ * comes from malloc()
+ */
+void * operator new(size_t size) {
+	t_allocs++;
+	void * p = malloc(size ? size : 1);
+	if (! p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void * operator new[](size_t size) {
+	return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept {
+	t_allocs++;
+	return malloc(size ? size : 1);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void * p) noexcept {
+	free(p);
+}
+
+void operator delete[](void * p) noexcept {
+	free(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) noexcept {
+	free(p);
+}
+
+void operator delete[](void * p, const std::nothrow_t &) noexcept {
+	free(p);
+}
+
+uint64_t alloc_count() {
+	return t_allocs;
+}
+
+/**
+ * @brief  Constructor
+ */
+BufferPool::BufferPool() {
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/**
+ * @brief  Get size class of a buffer, class N holds buffers of 2^N bytes
+ */
+size_t BufferPool::size_class(size_t size) {
+	size_t c = 0;
+	while (c < kClasses - 1 && ((size_t) 1 << c) < size)
+		++c;
+	return c;
+}
+
+/**
+ * @brief  Get an empty buffer with capacity of at least size bytes
+ *
+ * @param buf vector to place buffer to, its previous storage is pooled
+ * @param size requested capacity, 0 when not known in advance
+ */
+void BufferPool::get(std::vector<uint8_t> & buf, size_t size) {
+	m_stats.requests++;
+	put(buf);
+
+	/*
+	 * Unknown size gets the biggest buffer available
+	 */
+	if (size == 0) {
+		for (size_t c = kClasses; c-- > 0; ) {
+			if (! m_bins[c].empty()) {
+				buf.swap(m_bins[c].back());
+				m_bins[c].pop_back();
+				m_stats.reused++;
+				return;
+			}
+		}
+	} else {
+		for (size_t c = size_class(size); c < kClasses; ++c) {
+			if (! m_bins[c].empty()) {
+				buf.swap(m_bins[c].back());
+				m_bins[c].pop_back();
+				m_stats.reused++;
+				return;
+			}
+		}
+	}
+
+	m_stats.allocated++;
+	if (size)
+		buf.reserve((size_t) 1 << size_class(size));
+}
+
+/**
+ * @brief  Return buffer to the pool
+ *
+ * @param buf buffer to return, left empty without storage
+ */
+void BufferPool::put(std::vector<uint8_t> & buf) {
+	if (buf.capacity() == 0)
+		return;
+
+	buf.clear();
+	size_t c = size_class(buf.capacity() + 1) - 1; // largest class that fits
+	m_bins[c].push_back(std::vector<uint8_t>());
+	m_bins[c].back().swap(buf);
+}
+
+/**
+ * @brief  Free big pooled buffers
+ *
+ * @param size buffers with capacity over size are freed, except the ones
+ * less than twice as big
+ */
+void BufferPool::trim(size_t size) {
+	for (size_t c = size_class(size + 1); c < kClasses; ++c)
+		std::vector< std::vector<uint8_t> >().swap(m_bins[c]);
+}
@@ -0,0 +1,58 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 09:41:53 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <inttypes.h>
+#include <cstddef>
+
+#include <vector>
+
+/**
+ * @brief  Number of heap allocations (operator new) done by calling thread
+ */
+uint64_t alloc_count();
+
+/**
+ * @brief  Pool of byte buffers binned by power of two capacity
+ *
+ * Buffers are std::vectors, so they can be swapped in and out of structures
+ * that already hold their data in vectors without copying.
+ */
+class BufferPool {
+public:
+	/**
+	 * @brief  Pool counters
+	 */
+	struct stats_t {
+		uint64_t requests;		///< Calls to get()
+		uint64_t reused;			///< Requests satisfied by a pooled buffer
+		uint64_t allocated;		///< Requests which had to allocate a buffer
+	};
+
+	BufferPool();
+
+	void get(std::vector<uint8_t> & buf, size_t size);
+	void put(std::vector<uint8_t> & buf);
+	void trim(size_t size);
+
+	struct stats_t stats() const { return m_stats; }
+
+private:
+	static size_t size_class(size_t size);
+
+	static const size_t kClasses = 48;
+
+	std::vector< std::vector<uint8_t> > m_bins[kClasses];
+	struct stats_t m_stats;
+}; // class BufferPool
+
+#endif // POOL_H_
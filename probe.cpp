@@ -0,0 +1,338 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 08:37:45 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include "probe.h"
+#include "cache.h"
+#include "common.h"
+
+const size_t kProbeHeaderSize				= 13;
+const size_t kProbeDescriptorSize			= 9;
+
+/**
+ * @brief  Cursor over GIF bytes, reads past the end fail
+ */
+struct cursor_t {
+	const uint8_t * data;
+	size_t size;
+	size_t pos;
+};
+
+static inline bool take(struct cursor_t * c, size_t n) {
+	if (c->size - c->pos < n)
+		return false;
+	c->pos += n;
+	return true;
+}
+
+static inline uint16_t get16(const uint8_t * p) {
+	return p[0] | (p[1] << 8);
+}
+
+/**
+ * @brief  Skip data sub-blocks by their sizes, including block terminator
+ *
+ * @param c cursor
+ * @param count incremented for every sub-block, may be NULL
+ *
+ * @return  false on premature end of data
+ */
+static bool skip_sub_blocks(struct cursor_t * c, uint32_t * count = NULL) {
+	while (c->pos < c->size) {
+		uint8_t size = c->data[c->pos++];
+		if (size == 0)
+			return true;
+		if (! take(c, size))
+			return false;
+		if (count)
+			(*count)++;
+	}
+	return false;
+}
+
+/**
+ * @brief  Parse Application Extension, NETSCAPE/ANIMEXTS loop count is kept
+ */
+static bool probe_application(struct cursor_t * c, struct gif_info_t * info) {
+	const uint8_t * p = c->data + c->pos;
+	if (! take(c, 1) || ! take(c, p[0]))
+		return false;
+
+	if (p[0] == 11 && (memcmp(p + 1, "NETSCAPE2.0", 11) == 0
+				|| memcmp(p + 1, "ANIMEXTS1.0", 11) == 0)) {
+		const uint8_t * sub = c->data + c->pos;
+		if (c->size - c->pos >= 4 && sub[0] >= 3 && sub[1] == 1)
+			info->loop_count = get16(sub + 2);
+	}
+
+	return skip_sub_blocks(c);
+}
+
+static bool covers_screen(const struct gif_info_t & info, const struct gif_frame_info_t & f) {
+	return f.left == 0 && f.top == 0 && f.width >= info.width && f.height >= info.height;
+}
+
+/**
+ * @brief  Find first image which has to be drawn to display every image
+ *
+ * Screen does not depend on anything before a keyframe: either the image
+ * covers whole screen without transparency (and is not restored by
+ * kDisposalPrevious before a later image), or previous image cleared whole
+ * screen to background.
+ *
+ * @param info GIF metadata to update
+ */
+static void set_keyframes(struct gif_info_t * info) {
+	size_t clean = 0;
+
+	for (size_t i = 0; i < info->frames.size(); ++i) {
+		struct gif_frame_info_t & f = info->frames[i];
+		bool cleared = i == 0 || (covers_screen(*info, info->frames[i - 1])
+				&& info->frames[i - 1].disposal == kDisposalBackground);
+		bool opaque = covers_screen(*info, f) && f.transparent < 0;
+
+		f.keyframe = (cleared || opaque) ? i : clean;
+		if (cleared || (opaque && f.disposal != kDisposalPrevious))
+			clean = i;
+	}
+}
+
+/**
+ * @brief  Parse image descriptor and skip image data
+ */
+static bool probe_image(struct cursor_t * c, struct gif_info_t * info,
+		struct gif_frame_info_t * frame) {
+	frame->offset = c->pos - 1;
+
+	const uint8_t * p = c->data + c->pos;
+	if (! take(c, kProbeDescriptorSize)) {
+		err() << "Failed to read image descriptor!\n";
+		return false;
+	}
+
+	frame->left = get16(p);
+	frame->top = get16(p + 2);
+	frame->width = get16(p + 4);
+	frame->height = get16(p + 6);
+	frame->interlace = (p[8] >> 6) & 1;
+	frame->local_colors = (p[8] & 0x80) ? 1 << ((p[8] & 0x7) + 1) : 0;
+
+	if (! take(c, 3 * frame->local_colors)) {
+		err() << "Failed to read local color table!\n";
+		return false;
+	}
+
+	frame->data_offset = c->pos;
+	if (! take(c, 1) || ! skip_sub_blocks(c, &frame->sub_blocks)) {
+		err() << "Premature end of image data!\n";
+		return false;
+	}
+	frame->data_size = c->pos - frame->data_offset;
+
+	info->frames.push_back(*frame);
+	return true;
+}
+
+/**
+ * @brief  Collect GIF metadata, image data is skipped and not decoded
+ *
+ * @param data GIF bytes
+ * @param size size of data
+ * @param info output metadata
+ *
+ * @return  true on success
+ */
+bool gif_probe(const uint8_t * data, size_t size, struct gif_info_t * info) {
+	struct cursor_t cur = { data, size, 0 };
+	struct cursor_t * c = &cur;
+
+	info->frames.clear();
+	info->loop_count = -1;
+
+	if (! take(c, kProbeHeaderSize)) {
+		err() << "Failed to read header!\n";
+		return false;
+	}
+	if (memcmp(data, "GIF", 3) != 0) {
+		err() << "Input file is not a GIF file!\n";
+		return false;
+	}
+
+	memcpy(info->version, data + 3, 3);
+	info->version[3] = '\0';
+	info->width = get16(data + 6);
+	info->height = get16(data + 8);
+	info->global_colors = (data[10] & 0x80) ? 1 << ((data[10] & 0x7) + 1) : 0;
+	info->background = data[11];
+
+	if (! take(c, 3 * info->global_colors)) {
+		err() << "Failed to read global table!\n";
+		return false;
+	}
+
+	/*
+	 * Graphic Control Extension applies to the next image
+	 */
+	struct gif_frame_info_t frame;
+	memset(&frame, 0, sizeof(frame));
+	frame.transparent = -1;
+
+	while (c->pos < c->size) {
+		uint8_t b = c->data[c->pos++];
+
+		if (b == 0x3B) {
+			info->size = c->pos;
+			set_keyframes(info);
+			return true;
+		} else if (b == 0x2C) {
+			if (! probe_image(c, info, &frame))
+				return false;
+			memset(&frame, 0, sizeof(frame));
+			frame.transparent = -1;
+		} else if (b == 0x21 && c->pos < c->size) {
+			uint8_t label = c->data[c->pos++];
+			const uint8_t * p = c->data + c->pos;
+			bool ok;
+
+			if (label == 0xF9 && c->size - c->pos >= 5 && p[0] >= 4) {
+				frame.has_gce = true;
+				frame.disposal = (p[1] >> 2) & 0x7;
+				frame.delay = get16(p + 2);
+				frame.transparent = (p[1] & 1) ? p[4] : -1;
+				ok = skip_sub_blocks(c);
+			} else if (label == 0xFF) {
+				ok = probe_application(c, info);
+			} else {
+				ok = skip_sub_blocks(c);
+			}
+
+			if (! ok) {
+				err() << "Premature end of extension!\n";
+				return false;
+			}
+		} else {
+			err() << "Unknown start byte '" << std::hex << (unsigned) b << std::dec
+					<< "', extension or EOF expected!\n";
+			return false;
+		}
+	}
+
+	/*
+	 * Trailer is missing, but all blocks are complete
+	 */
+	warn() << "Missing GIF trailer!\n";
+	info->size = c->pos;
+	set_keyframes(info);
+	return true;
+}
+
+/**
+ * @brief  Collect GIF metadata of a file
+ *
+ * Regular files are mapped to memory, so that image data are never read,
+ * other input is read whole.
+ *
+ * @param f file to probe, read from current position
+ * @param info output metadata
+ *
+ * @return  true on success
+ */
+bool gif_probe_file(FILE * f, struct gif_info_t * info) {
+	struct stat st;
+	int fd = fileno(f);
+	off_t start = lseek(fd, 0, SEEK_CUR);
+
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && start >= 0 && st.st_size > start) {
+		void * map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			bool res = gif_probe((const uint8_t *) map + start, st.st_size - start, info);
+			munmap(map, st.st_size);
+			return res;
+		}
+	}
+
+	std::vector<char> data;
+	if (! read_all(f, data)) {
+		err() << "Failed to read input!\n";
+		return false;
+	}
+
+	return gif_probe((const uint8_t *) data.data(), data.size(), info);
+}
+
+/**
+ * @brief  Print string as JSON string, bytes other than printable ASCII
+ * are escaped
+ *
+ * @param out file to print to
+ * @param str string to print
+ */
+static void json_string(FILE * out, const char * str) {
+	fputc('"', out);
+	for (const unsigned char * p = (const unsigned char *) str; *p; ++p) {
+		if (*p == '"' || *p == '\\')
+			fprintf(out, "\\%c", *p);
+		else if (*p < 0x20 || *p > 0x7e)
+			fprintf(out, "\\u%04x", *p);
+		else
+			fputc(*p, out);
+	}
+	fputc('"', out);
+}
+
+/**
+ * @brief  Print metadata as JSON
+ *
+ * @param out file to print to
+ * @param info metadata to print
+ */
+void gif_info_json(FILE * out, const struct gif_info_t * info) {
+	// version is copied from the file as it is, GIF87a/GIF89a are not required
+	fputs("{\n  \"version\": ", out);
+	json_string(out, info->version);
+	fprintf(out, ",\n  \"width\": %u,\n  \"height\": %u,\n"
+			"  \"globalColors\": %u,\n  \"background\": %u,\n",
+			info->width, info->height, info->global_colors, info->background);
+
+	if (info->loop_count >= 0)
+		fprintf(out, "  \"loopCount\": %d,\n", info->loop_count);
+	else
+		fputs("  \"loopCount\": null,\n", out);
+
+	fprintf(out, "  \"size\": %" PRIu64 ",\n  \"frameCount\": %zu,\n  \"frames\": [",
+			info->size, info->frames.size());
+
+	for (size_t i = 0; i < info->frames.size(); ++i) {
+		const struct gif_frame_info_t & fr = info->frames[i];
+		fprintf(out, "%s\n    { \"left\": %u, \"top\": %u, \"width\": %u, \"height\": %u, "
+				"\"interlace\": %s, \"localColors\": %u, ",
+				i ? "," : "", fr.left, fr.top, fr.width, fr.height,
+				fr.interlace ? "true" : "false", fr.local_colors);
+		if (fr.has_gce)
+			fprintf(out, "\"delay\": %u, \"disposal\": %u, ", fr.delay, fr.disposal);
+		else
+			fputs("\"delay\": null, \"disposal\": null, ", out);
+		if (fr.transparent >= 0)
+			fprintf(out, "\"transparent\": %d, ", fr.transparent);
+		else
+			fputs("\"transparent\": null, ", out);
+		fprintf(out, "\"keyframe\": %u, \"offset\": %" PRIu64 ", \"dataSize\": %" PRIu64 " }",
+				fr.keyframe, fr.offset, fr.data_size);
+	}
+
+	fputs(info->frames.empty() ? "]\n}\n" : "\n  ]\n}\n", out);
+}
@@ -0,0 +1,68 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 08:37:45 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef PROBE_H_
+#define PROBE_H_
+
+#include <inttypes.h>
+#include <cstdio>
+
+#include <vector>
+
+/**
+ * @brief  Disposal methods of Graphic Control Extension
+ */
+enum disposal_t {
+	kDisposalNone			= 0,		///< Not specified
+	kDisposalKeep			= 1,		///< Leave frame in place
+	kDisposalBackground	= 2,		///< Restore area to background
+	kDisposalPrevious		= 3		///< Restore area to previous content
+};
+
+/**
+ * @brief  Metadata of one image of GIF
+ */
+struct gif_frame_info_t {
+	uint16_t left;
+	uint16_t top;
+	uint16_t width;
+	uint16_t height;
+	bool interlace;
+	unsigned local_colors;		///< Size of local color table, 0 if there is none
+	bool has_gce;					///< Graphic Control Extension precedes image
+	uint16_t delay;				///< Delay after image in 1/100 s
+	unsigned disposal;			///< disposal_t
+	int transparent;				///< Transparent color index, -1 if none
+	uint64_t offset;				///< Offset of image separator in file
+	uint64_t data_offset;		///< Offset of LZW minimum code size byte
+	uint64_t data_size;			///< Image data including sub-block sizes
+	uint32_t sub_blocks;			///< Number of image data sub-blocks
+	uint32_t keyframe;			///< First image which has to be drawn to display this one
+};
+
+/**
+ * @brief  Metadata of GIF, as collected without decoding images
+ */
+struct gif_info_t {
+	char version[4];				///< "87a" or "89a"
+	uint16_t width;				///< Logical screen
+	uint16_t height;
+	unsigned global_colors;		///< Size of global color table, 0 if there is none
+	uint8_t background;			///< Background color index
+	int loop_count;				///< NETSCAPE loop count (0 forever), -1 if absent
+	uint64_t size;					///< Bytes of GIF up to trailer
+	std::vector<struct gif_frame_info_t> frames;
+};
+
+bool gif_probe(const uint8_t * data, size_t size, struct gif_info_t * info);
+bool gif_probe_file(FILE * f, struct gif_info_t * info);
+void gif_info_json(FILE * out, const struct gif_info_t * info);
+
+#endif // PROBE_H_
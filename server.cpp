@@ -0,0 +1,584 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 10:12:40 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <unistd.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "server.h"
+#include "gif2bmp.h"
+#include "cache.h"
+#include "trace.h"
+#include "common.h"
+
+const size_t kMaxLineSize				= 4096;
+const size_t kMaxDataSize				= 256 << 20;
+const size_t kWarmPixels				= 256 * 256;
+const size_t kLatencyBuckets			= 32;
+const time_t kIdleTimeout				= 30;	///< Seconds a client may leave socket idle
+
+/**
+ * @brief  Set by signal handler to stop accepting new connections
+ */
+static volatile sig_atomic_t g_stop = 0;
+
+/**
+ * @brief  Server statistics
+ */
+struct stats_t {
+	std::mutex lock;
+	uint64_t requests;					///< All requests
+	uint64_t converted;					///< Successful conversions
+	uint64_t failed;						///< Failed or malformed requests
+	uint64_t bytes_in;					///< GIF bytes received/read
+	uint64_t bytes_out;					///< BMP bytes sent/written
+	uint64_t allocs;						///< Heap allocations done by conversions
+	uint64_t stage_us[kStageCount];		///< Wall time spent in conversion stages
+	uint64_t latency[kLatencyBuckets];	///< Histogram, bucket i holds <2^i us
+};
+
+/**
+ * @brief  Connections waiting for a worker
+ */
+struct queue_t {
+	std::mutex lock;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	std::deque<int> fds;
+	size_t max;
+	bool done;
+};
+
+/**
+ * @brief  State shared by all workers
+ */
+struct shared_t {
+	struct stats_t stats;
+	struct queue_t queue;
+	class ConvCache * cache;		///< May be NULL
+};
+
+/**
+ * @brief  Buffered reader on a connection
+ */
+struct conn_t {
+	int fd;
+	char buf[kMaxLineSize];
+	size_t pos;
+	size_t len;
+};
+
+static void on_signal(int sig) {
+	UNUSED(sig);
+	g_stop = 1;
+}
+
+/**
+ * @brief  Write whole buffer to a socket
+ *
+ * @param fd socket to write to
+ * @param buf data to write
+ * @param len size of data
+ *
+ * @return  true on success
+ */
+static bool write_all(int fd, const void * buf, size_t len) {
+	const char * p = (const char *) buf;
+	while (len) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+/**
+ * @brief  Fill connection buffer if it is empty
+ *
+ * @return  false on EOF or error
+ */
+static bool fill(struct conn_t * c) {
+	if (c->pos < c->len)
+		return true;
+
+	ssize_t n;
+	do {
+		n = read(c->fd, c->buf, sizeof(c->buf));
+	} while (n < 0 && errno == EINTR);
+
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		info() << "Closing connection idle for " << kIdleTimeout << " s\n";
+	if (n <= 0)
+		return false;
+
+	c->pos = 0;
+	c->len = n;
+	return true;
+}
+
+/**
+ * @brief  Read a request line, without trailing newline
+ *
+ * @return  false on EOF, error or too long line
+ */
+static bool read_line(struct conn_t * c, std::string & line) {
+	line.clear();
+	while (fill(c)) {
+		char * start = c->buf + c->pos;
+		char * nl = (char *) memchr(start, '\n', c->len - c->pos);
+		size_t n = nl ? (size_t) (nl - start) : c->len - c->pos;
+
+		line.append(start, n);
+		c->pos += n + (nl ? 1 : 0);
+
+		if (nl)
+			return true;
+		if (line.size() > kMaxLineSize)
+			return false;
+	}
+	return false;
+}
+
+/**
+ * @brief  Read exactly len bytes of request payload
+ *
+ * @return  false on premature EOF
+ */
+static bool read_data(struct conn_t * c, char * data, size_t len) {
+	while (len) {
+		if (! fill(c))
+			return false;
+		size_t n = std::min(len, c->len - c->pos);
+		memcpy(data, c->buf + c->pos, n);
+		c->pos += n;
+		data += n;
+		len -= n;
+	}
+	return true;
+}
+
+/**
+ * @brief  Account finished request
+ *
+ * @param status counters of successful conversion, NULL when it failed
+ */
+static void record(struct stats_t * stats, bool ok, size_t in, size_t out,
+		const struct gif2bmp_t * status, std::chrono::steady_clock::time_point start) {
+	uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count();
+	size_t bucket = 0;
+	while (bucket < kLatencyBuckets - 1 && (1ULL << bucket) <= us)
+		++bucket;
+
+	std::lock_guard<std::mutex> guard(stats->lock);
+	stats->requests++;
+	if (ok) stats->converted++; else stats->failed++;
+	stats->bytes_in += in;
+	stats->bytes_out += out;
+	stats->latency[bucket]++;
+	if (status) {
+		stats->allocs += status->allocs;
+		for (size_t i = 0; i < kStageCount; ++i)
+			stats->stage_us[i] += status->stages[i].wall_us;
+	}
+}
+
+/**
+ * @brief  Send statistics to client
+ */
+static bool send_stats(int fd, struct shared_t * shared) {
+	struct stats_t * stats = &shared->stats;
+	struct queue_t * queue = &shared->queue;
+	std::string out;
+	char line[128];
+
+	if (shared->cache) {
+		struct ConvCache::stats_t cs = shared->cache->stats();
+		snprintf(line, sizeof(line), "cacheMemHits = %" PRIu64 "\n", cs.mem_hits);
+		out += line;
+		snprintf(line, sizeof(line), "cacheDiskHits = %" PRIu64 "\n", cs.disk_hits);
+		out += line;
+		snprintf(line, sizeof(line), "cacheMisses = %" PRIu64 "\n", cs.misses);
+		out += line;
+		snprintf(line, sizeof(line), "cacheEntries = %" PRIu64 "\n", cs.entries);
+		out += line;
+		snprintf(line, sizeof(line), "cacheBytes = %" PRIu64 "\n", cs.bytes);
+		out += line;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(queue->lock);
+		snprintf(line, sizeof(line), "queued = %zu\n", queue->fds.size());
+		out += line;
+	}
+
+	std::lock_guard<std::mutex> guard(stats->lock);
+	snprintf(line, sizeof(line), "requests = %" PRIu64 "\n", stats->requests);
+	out += line;
+	snprintf(line, sizeof(line), "converted = %" PRIu64 "\n", stats->converted);
+	out += line;
+	snprintf(line, sizeof(line), "failed = %" PRIu64 "\n", stats->failed);
+	out += line;
+	snprintf(line, sizeof(line), "bytesIn = %" PRIu64 "\n", stats->bytes_in);
+	out += line;
+	snprintf(line, sizeof(line), "bytesOut = %" PRIu64 "\n", stats->bytes_out);
+	out += line;
+	snprintf(line, sizeof(line), "allocs = %" PRIu64 "\n", stats->allocs);
+	out += line;
+	for (size_t i = 0; i < kStageCount; ++i) {
+		snprintf(line, sizeof(line), "%sWallUs = %" PRIu64 "\n", kStageNames[i], stats->stage_us[i]);
+		out += line;
+	}
+	for (size_t i = 0; i < kLatencyBuckets; ++i) {
+		if (! stats->latency[i])
+			continue;
+		snprintf(line, sizeof(line), "latencyUs[<%llu] = %" PRIu64 "\n",
+				1ULL << i, stats->latency[i]);
+		out += line;
+	}
+	out += "END\n";
+
+	return write_all(fd, out.data(), out.size());
+}
+
+/**
+ * @brief  Convert files given by path
+ */
+static bool handle_convert(int fd, const std::string & args,
+		struct shared_t * shared, struct gif2bmp_ctx_t * ctx, std::vector<char> & data) {
+	struct stats_t * stats = &shared->stats;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t sep = args.find(' ');
+	if (sep == std::string::npos) {
+		record(stats, false, 0, 0, NULL, start);
+		return write_all(fd, "ERR expected two paths\n", 23);
+	}
+
+	std::string in_path = args.substr(0, sep);
+	std::string out_path = args.substr(sep + 1);
+	struct gif2bmp_t status = gif2bmp_t();
+	int res = 1;
+
+	FILE * in_file = fopen(in_path.c_str(), "rb");
+	FILE * out_file = in_file ? fopen(out_path.c_str(), "wb") : NULL;
+	if (in_file && out_file) {
+		if (shared->cache) {
+			if (read_all(in_file, data))
+				res = gif2bmp_cached(shared->cache, &status, data.data(), data.size(), out_file, ctx);
+		} else {
+			res = gif2bmp(&status, in_file, out_file, ctx);
+		}
+	}
+	// header of BMP does not count row padding, reply with size of the file
+	// (not known for pipes, which cannot tell their position)
+	long written = res == 0 ? ftell(out_file) : -1;
+	if (written < 0)
+		written = status.bmp_size;
+	if (in_file) fclose(in_file);
+	if (out_file && fclose(out_file) != 0)
+		res = 1;
+
+	if (res != 0) {
+		record(stats, false, 0, 0, NULL, start);
+		if (! in_file || ! out_file) {
+			std::string msg = std::string("ERR ") + strerror(errno) + "\n";
+			return write_all(fd, msg.data(), msg.size());
+		}
+		return write_all(fd, "ERR conversion failed\n", 22);
+	}
+
+	record(stats, true, status.gif_size, written, &status, start);
+	char reply[64];
+	int n = snprintf(reply, sizeof(reply), "OK %ld\n", written);
+	return write_all(fd, reply, n);
+}
+
+/**
+ * @brief  Convert GIF sent inline, reply with BMP bytes
+ */
+static bool handle_data(struct conn_t * c, const std::string & args,
+		struct shared_t * shared, struct gif2bmp_ctx_t * ctx, std::vector<char> & data) {
+	struct stats_t * stats = &shared->stats;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	char * end = NULL;
+	unsigned long long len = strtoull(args.c_str(), &end, 10);
+	if (args.empty() || *end != '\0' || len == 0 || len > kMaxDataSize) {
+		record(stats, false, 0, 0, NULL, start);
+		write_all(c->fd, "ERR bad length\n", 15);
+		return false; // cannot resync with client stream
+	}
+
+	data.resize(len);
+	if (! read_data(c, &data[0], len))
+		return false;
+
+	char * bmp = NULL;
+	size_t bmp_len = 0;
+	struct gif2bmp_t status = gif2bmp_t();
+	int res = 1;
+
+	FILE * out_file = open_memstream(&bmp, &bmp_len);
+	FILE * in_file = NULL;
+	if (shared->cache) {
+		if (out_file)
+			res = gif2bmp_cached(shared->cache, &status, &data[0], len, out_file, ctx);
+	} else {
+		in_file = fmemopen(&data[0], len, "rb");
+		if (in_file && out_file)
+			res = gif2bmp(&status, in_file, out_file, ctx);
+	}
+	if (in_file) fclose(in_file);
+	if (out_file) fclose(out_file);
+
+	bool ok;
+	if (res != 0) {
+		record(stats, false, len, 0, NULL, start);
+		ok = write_all(c->fd, "ERR conversion failed\n", 22);
+	} else {
+		record(stats, true, len, bmp_len, &status, start);
+		char reply[64];
+		int n = snprintf(reply, sizeof(reply), "OK %zu\n", bmp_len);
+		ok = write_all(c->fd, reply, n) && write_all(c->fd, bmp, bmp_len);
+	}
+
+	free(bmp);
+	return ok;
+}
+
+/**
+ * @brief  Free buffers grown by a big request, with memory budget only
+ *
+ * Memory of a conversion is returned to budget when it ends, but storage of
+ * worker would keep it otherwise.
+ */
+static void trim(struct gif2bmp_ctx_t * ctx, std::vector<char> & data) {
+	if (! g_limits.memory)
+		return;
+
+	gif2bmp_trim(ctx, kWarmPixels);
+	if (data.capacity() > kWarmPixels) {
+		std::vector<char>().swap(data);
+		data.reserve(kWarmPixels);
+	}
+}
+
+/**
+ * @brief  Limit how long a client can keep worker waiting
+ *
+ * Reads and writes blocked for kIdleTimeout fail, so an idle or stalled
+ * client is disconnected instead of holding its worker forever.
+ *
+ * @param fd accepted connection
+ *
+ * @return  false on error
+ */
+static bool set_timeouts(int fd) {
+	struct timeval tv;
+	tv.tv_sec = kIdleTimeout;
+	tv.tv_usec = 0;
+	return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0
+			&& setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) == 0;
+}
+
+/**
+ * @brief  Serve requests on one connection until client closes it
+ */
+static void handle_connection(int fd, struct shared_t * shared,
+		struct gif2bmp_ctx_t * ctx, std::vector<char> & data) {
+	struct conn_t * c = new struct conn_t;
+	std::string line;
+	bool ok = true;
+
+	c->fd = fd;
+	c->pos = c->len = 0;
+
+	while (ok && read_line(c, line)) {
+		size_t sep = line.find(' ');
+		std::string cmd = line.substr(0, sep);
+		std::string args = sep == std::string::npos ? "" : line.substr(sep + 1);
+
+		if (cmd == "CONVERT") {
+			TRACE_SPAN("CONVERT");
+			ok = handle_convert(fd, args, shared, ctx, data);
+			trim(ctx, data);
+		} else if (cmd == "DATA") {
+			TRACE_SPAN("DATA");
+			ok = handle_data(c, args, shared, ctx, data);
+			trim(ctx, data);
+		} else if (cmd == "STATS") {
+			ok = send_stats(fd, shared);
+		} else {
+			ok = write_all(fd, "ERR unknown command\n", 20);
+		}
+	}
+
+	delete c;
+	close(fd);
+	log_summary();
+}
+
+/**
+ * @brief  Worker thread, owns its own warm decoder storage
+ */
+static void worker(struct shared_t * shared) {
+	struct queue_t * queue = &shared->queue;
+	struct gif2bmp_ctx_t ctx;
+	std::vector<char> data;
+
+	gif2bmp_warm(&ctx, kWarmPixels);
+	data.reserve(kWarmPixels);
+
+	for (;;) {
+		int fd;
+		{
+			std::unique_lock<std::mutex> guard(queue->lock);
+			while (queue->fds.empty() && ! queue->done)
+				queue->not_empty.wait(guard);
+			if (queue->fds.empty())
+				return;
+			fd = queue->fds.front();
+			queue->fds.pop_front();
+		}
+		queue->not_full.notify_one();
+
+		handle_connection(fd, shared, &ctx, data);
+	}
+}
+
+/**
+ * @brief  Run conversion server until SIGINT or SIGTERM
+ *
+ * @param opts server options
+ *
+ * @return  0 on success
+ */
+int serve(const struct serve_opts_t * opts) {
+	struct sockaddr_un addr;
+
+	if (strlen(opts->socket_path) >= sizeof(addr.sun_path)) {
+		err() << "Socket path '" << opts->socket_path << "' is too long!\n";
+		return 1;
+	}
+
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0) {
+		perror("socket");
+		return 1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, opts->socket_path);
+	unlink(opts->socket_path);
+
+	if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0
+			|| listen(sock, opts->queue_size) < 0) {
+		perror(opts->socket_path);
+		close(sock);
+		return 1;
+	}
+
+	/*
+	 * No SA_RESTART, accept() has to be interrupted
+	 */
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	struct shared_t * shared = new struct shared_t;
+	struct stats_t * stats = &shared->stats;
+	struct queue_t * queue = &shared->queue;
+	shared->cache = NULL;
+	if (opts->cache_size || opts->cache_dir)
+		shared->cache = new ConvCache(opts->cache_size, opts->cache_dir);
+	stats->requests = stats->converted = stats->failed = 0;
+	stats->bytes_in = stats->bytes_out = stats->allocs = 0;
+	memset(stats->latency, 0, sizeof(stats->latency));
+	memset(stats->stage_us, 0, sizeof(stats->stage_us));
+	queue->max = opts->queue_size;
+	queue->done = false;
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < opts->workers; ++i)
+		workers.push_back(std::thread(worker, shared));
+
+	info() << "Listening on '" << opts->socket_path << "' with "
+			<< opts->workers << " workers\n";
+
+	while (! g_stop) {
+		/*
+		 * Backpressure: do not accept while all slots are taken, clients
+		 * wait in the listen backlog instead
+		 */
+		{
+			std::unique_lock<std::mutex> guard(queue->lock);
+			while (queue->fds.size() >= queue->max && ! g_stop)
+				queue->not_full.wait_for(guard, std::chrono::milliseconds(100));
+		}
+
+		int fd = accept(sock, NULL, NULL);
+		if (fd < 0) {
+			if (errno != EINTR)
+				perror("accept");
+			continue;
+		}
+		if (! set_timeouts(fd)) {
+			perror("setsockopt");
+			close(fd);
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(queue->lock);
+			queue->fds.push_back(fd);
+		}
+		queue->not_empty.notify_one();
+	}
+
+	info() << "Shutting down\n";
+	{
+		std::lock_guard<std::mutex> guard(queue->lock);
+		queue->done = true;
+	}
+	queue->not_empty.notify_all();
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+
+	close(sock);
+	unlink(opts->socket_path);
+	delete shared->cache;
+	delete shared;
+
+	return 0;
+}
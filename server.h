@@ -0,0 +1,35 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 10:12:40 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef SERVER_H_
+#define SERVER_H_
+
+/*
+ * Protocol (one request per line, multiple requests per connection):
+ *
+ *   CONVERT <gif path> <bmp path>\n   -> OK <bmp size>\n | ERR <reason>\n
+ *   DATA <length>\n<length bytes>      -> OK <length>\n<BMP bytes> | ERR <reason>\n
+ *   STATS\n                            -> <key> = <value>\n ... END\n
+ */
+
+/**
+ * @brief  Conversion server options
+ */
+struct serve_opts_t {
+	const char * socket_path;		///< Unix domain socket to listen on
+	unsigned workers;					///< Number of worker threads
+	unsigned queue_size;				///< Max number of connections waiting for a worker
+	size_t cache_size;				///< Memory for cached results, 0 disables cache
+	const char * cache_dir;			///< Directory for cached results, may be NULL
+};
+
+int serve(const struct serve_opts_t * opts);
+
+#endif // SERVER_H_
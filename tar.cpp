@@ -0,0 +1,158 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 12:41:05 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+
+#include "tar.h"
+#include "common.h"
+
+const size_t kTarBlockSize		= 512;
+const size_t kTarNameSize		= 100;
+
+/**
+ * @brief  Store octal number to header field of size len, NUL terminated
+ *
+ * Numbers which do not fit are stored in base-256 (GNU extension).
+ */
+static void put_octal(char * p, size_t len, uint64_t v) {
+	if (len - 1 < 22 && (v >> (3 * (len - 1))) != 0) {
+		p[0] = (char) 0x80;
+		for (size_t i = len - 1; i > 0; --i, v >>= 8)
+			p[i] = v & 0xFF;
+		return;
+	}
+
+	p[len - 1] = '\0';
+	for (size_t i = len - 1; i > 0; --i, v >>= 3)
+		p[i - 1] = '0' + (v & 7);
+}
+
+/**
+ * @brief  Constructor
+ *
+ * @param f output file, written sequentially
+ */
+TarWriter::TarWriter(FILE * f) : m_file(f), m_size(0), m_mtime(time(NULL)) {
+}
+
+/**
+ * @brief  Write header of entry
+ *
+ * @param name file name, up to 99 characters
+ * @param size size of data
+ * @param type '0' for regular file, '1' for hard link
+ * @param target file linked to, NULL for regular file
+ *
+ * @return  true on success
+ */
+bool TarWriter::header(const char * name, uint64_t size, char type, const char * target) {
+	char header[kTarBlockSize];
+
+	if (strlen(name) >= kTarNameSize || (target && strlen(target) >= kTarNameSize)) {
+		err() << "File name '" << name << "' is too long for tar!\n";
+		return false;
+	}
+
+	memset(header, 0, sizeof(header));
+	strcpy(header, name);
+	put_octal(header + 100, 8, 0644);		// mode
+	put_octal(header + 108, 8, 0);			// uid
+	put_octal(header + 116, 8, 0);			// gid
+	put_octal(header + 124, 12, size);
+	put_octal(header + 136, 12, m_mtime);
+	memset(header + 148, ' ', 8);				// checksum is computed with spaces
+	header[156] = type;
+	if (target)
+		strcpy(header + 157, target);
+	memcpy(header + 257, "ustar", 6);
+	memcpy(header + 263, "00", 2);
+
+	unsigned sum = 0;
+	for (size_t i = 0; i < sizeof(header); ++i)
+		sum += (uint8_t) header[i];
+	put_octal(header + 148, 7, sum);
+
+	if (fwrite(header, sizeof(header), 1, m_file) != 1) {
+		err() << "Failed to write output!\n";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Start entry of a regular file, its data are written to file() then
+ *
+ * @param name file name, up to 99 characters
+ * @param size exact size of data
+ *
+ * @return  true on success
+ */
+bool TarWriter::begin(const char * name, uint64_t size) {
+	m_size = size;
+	return header(name, size, '0', NULL);
+}
+
+/**
+ * @brief  Add hard link to file stored earlier, it has no data
+ *
+ * @param name file name, up to 99 characters
+ * @param target name of file stored earlier
+ *
+ * @return  true on success
+ */
+bool TarWriter::link(const char * name, const char * target) {
+	return header(name, 0, '1', target);
+}
+
+/**
+ * @brief  Finish entry, pad its data to block size
+ *
+ * @return  true on success
+ */
+bool TarWriter::end() {
+	static const char kZeros[kTarBlockSize] = { 0 };
+	size_t pad = (kTarBlockSize - m_size % kTarBlockSize) % kTarBlockSize;
+
+	if (pad && fwrite(kZeros, 1, pad, m_file) != pad) {
+		err() << "Failed to write output!\n";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Write end of archive, flush it and sync it to disk once
+ *
+ * @return  true on success
+ */
+bool TarWriter::finish() {
+	static const char kZeros[2 * kTarBlockSize] = { 0 };
+
+	if (fwrite(kZeros, sizeof(kZeros), 1, m_file) != 1 || fflush(m_file) != 0) {
+		err() << "Failed to write output!\n";
+		return false;
+	}
+
+	/*
+	 * pipes and sockets cannot be synced
+	 */
+	if (fsync(fileno(m_file)) != 0 && errno != EINVAL && errno != EROFS) {
+		err() << "Failed to sync output!\n";
+		return false;
+	}
+
+	return true;
+}
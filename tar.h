@@ -0,0 +1,45 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 12:41:05 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef TAR_H_
+#define TAR_H_
+
+#include <inttypes.h>
+#include <cstdio>
+
+/**
+ * @brief  Writer of uncompressed (ustar) archive
+ *
+ * Entries are written sequentially, so that output does not have to be
+ * seekable: size of an entry has to be known when it is started.
+ */
+class TarWriter {
+public:
+	TarWriter(FILE * f);
+
+	bool begin(const char * name, uint64_t size);
+	bool end();
+	bool link(const char * name, const char * target);
+	bool finish();
+
+	FILE * file() { return m_file; }
+
+private:
+	TarWriter(const TarWriter &);
+	TarWriter & operator=(const TarWriter &);
+
+	bool header(const char * name, uint64_t size, char type, const char * target);
+
+	FILE * m_file;
+	uint64_t m_size;				///< Size of current entry
+	int64_t m_mtime;				///< Modification time of entries
+};
+
+#endif // TAR_H_
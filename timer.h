@@ -0,0 +1,56 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 05:02:36 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <inttypes.h>
+#include <ctime>
+
+/**
+ * @brief  Time spent in a stage, in microseconds
+ */
+struct stage_time_t {
+	uint64_t wall_us;		///< Elapsed real time
+	uint64_t cpu_us;		///< CPU time of calling thread
+};
+
+inline uint64_t clock_us(clockid_t clock) {
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief  Adds time between construction and destruction to a stage
+ */
+class StageTimer {
+public:
+	StageTimer(struct stage_time_t * stage) : m_stage(stage) {
+		if (m_stage) {
+			m_wall = clock_us(CLOCK_MONOTONIC);
+			m_cpu = clock_us(CLOCK_THREAD_CPUTIME_ID);
+		}
+	}
+
+	~StageTimer() {
+		if (m_stage) {
+			m_stage->wall_us += clock_us(CLOCK_MONOTONIC) - m_wall;
+			m_stage->cpu_us += clock_us(CLOCK_THREAD_CPUTIME_ID) - m_cpu;
+		}
+	}
+
+private:
+	struct stage_time_t * m_stage;
+	uint64_t m_wall;
+	uint64_t m_cpu;
+};
+
+#endif // TIMER_H_
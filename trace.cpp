@@ -0,0 +1,138 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 06:14:51 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <ctime>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <vector>
+#include <mutex>
+
+#include "trace.h"
+
+#ifdef GIF2BMP_TRACE
+
+const size_t kTraceEvents				= 1 << 16;
+
+/**
+ * @brief  Recorded span
+ */
+struct trace_event_t {
+	const char * name;
+	int64_t arg;
+	uint64_t start;			///< ns since trace_start()
+	uint64_t end;
+};
+
+/**
+ * @brief  Events of one thread, oldest are overwritten when full
+ */
+struct trace_ring_t {
+	unsigned tid;
+	uint64_t count;			///< Events recorded, including overwritten ones
+	struct trace_event_t events[kTraceEvents];
+};
+
+bool g_trace_enabled = false;
+
+static uint64_t g_origin = 0;
+static std::mutex g_rings_lock;
+static std::vector<struct trace_ring_t *> g_rings;
+static thread_local struct trace_ring_t * t_ring = NULL;
+
+static uint64_t mono_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief  Current time for spans, never 0 once tracing started
+ */
+uint64_t trace_now() {
+	return mono_ns() - g_origin + 1;
+}
+
+/**
+ * @brief  Store finished span to ring of calling thread
+ */
+void trace_record(const char * name, int64_t arg, uint64_t start, uint64_t end) {
+	if (! t_ring) {
+		t_ring = new struct trace_ring_t;
+		t_ring->count = 0;
+		std::lock_guard<std::mutex> guard(g_rings_lock);
+		t_ring->tid = g_rings.size() + 1;
+		g_rings.push_back(t_ring);
+	}
+
+	struct trace_event_t & e = t_ring->events[t_ring->count++ % kTraceEvents];
+	e.name = name;
+	e.arg = arg;
+	e.start = start;
+	e.end = end;
+}
+
+#endif // GIF2BMP_TRACE
+
+/**
+ * @brief  Whether tracing was compiled in
+ */
+bool trace_available() {
+#ifdef GIF2BMP_TRACE
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief  Start recording spans, call before worker threads are started
+ */
+void trace_start() {
+#ifdef GIF2BMP_TRACE
+	g_origin = mono_ns();
+	g_trace_enabled = true;
+#endif
+}
+
+/**
+ * @brief  Write recorded spans as Chrome trace JSON, threads recording spans
+ * have to be finished
+ *
+ * @param f file to write to
+ *
+ * @return  true on success
+ */
+bool trace_write(FILE * f) {
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+
+#ifdef GIF2BMP_TRACE
+	std::lock_guard<std::mutex> guard(g_rings_lock);
+	const char * sep = "";
+	for (size_t i = 0; i < g_rings.size(); ++i) {
+		struct trace_ring_t * ring = g_rings[i];
+		uint64_t first = ring->count > kTraceEvents ? ring->count - kTraceEvents : 0;
+
+		for (uint64_t n = first; n < ring->count; ++n) {
+			const struct trace_event_t & e = ring->events[n % kTraceEvents];
+			fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+					"\"ts\":%.3f,\"dur\":%.3f", sep, e.name, ring->tid,
+					e.start / 1e3, (e.end - e.start) / 1e3);
+			if (e.arg >= 0)
+				fprintf(f, ",\"args\":{\"n\":%" PRId64 "}", e.arg);
+			fputs("}", f);
+			sep = ",\n";
+		}
+	}
+#endif
+
+	fputs("\n]}\n", f);
+	return ! ferror(f);
+}
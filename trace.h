@@ -0,0 +1,71 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 06:14:51 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <inttypes.h>
+#include <cstdio>
+
+/*
+ * Spans of work on a timeline, written as Chrome trace events (load the file
+ * in chrome://tracing or ui.perfetto.dev). Tracing is compiled in only with
+ * GIF2BMP_TRACE defined (make TRACE=1), otherwise TRACE_SPAN() expands to
+ * nothing. When compiled in, a span costs one branch until trace_start().
+ */
+
+#ifdef GIF2BMP_TRACE
+
+/**
+ * @brief  Set by trace_start(), spans are recorded only when set
+ */
+extern bool g_trace_enabled;
+
+uint64_t trace_now();
+void trace_record(const char * name, int64_t arg, uint64_t start, uint64_t end);
+
+/**
+ * @brief  Records a span from construction to destruction
+ */
+class TraceSpan {
+public:
+	/**
+	 * @param name span name, has to be a string literal
+	 * @param arg number shown with span (image index...), -1 for none
+	 */
+	TraceSpan(const char * name, int64_t arg = -1)
+			: m_name(name), m_arg(arg), m_start(g_trace_enabled ? trace_now() : 0) { }
+
+	~TraceSpan() {
+		if (m_start)
+			trace_record(m_name, m_arg, m_start, trace_now());
+	}
+
+private:
+	const char * m_name;
+	int64_t m_arg;
+	uint64_t m_start;
+};
+
+#	define TRACE_CONCAT_(A, B)		A##B
+#	define TRACE_CONCAT(A, B)		TRACE_CONCAT_(A, B)
+#	define TRACE_SPAN(...)			TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(__VA_ARGS__)
+
+#else
+
+#	define TRACE_SPAN(...)
+
+#endif // GIF2BMP_TRACE
+
+bool trace_available();
+void trace_start();
+bool trace_write(FILE * f);
+
+#endif // TRACE_H_
@@ -0,0 +1,459 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 02:37:19 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "watch.h"
+#include "gif2bmp.h"
+#include "common.h"
+
+const size_t kWatchWarmPixels			= 256 * 256;
+const size_t kEventBufferSize			= 64 * 1024;
+
+typedef std::chrono::steady_clock watch_clock;
+
+/**
+ * @brief  Set by signal handler to stop watching
+ */
+static volatile sig_atomic_t g_stop = 0;
+
+/**
+ * @brief  File waiting for a worker
+ */
+struct job_t {
+	std::string name;						///< Name in watched directory
+	watch_clock::time_point queued;	///< When it was seen closed
+};
+
+/**
+ * @brief  Watch statistics, latency is counted from queuing to moving input
+ */
+struct watch_stats_t {
+	std::mutex lock;
+	uint64_t converted;
+	uint64_t failed;
+	uint64_t running;						///< Files being converted right now
+	uint64_t period_files;				///< Files finished since last report
+	uint64_t period_latency_us;			///< Sum of their latencies
+	uint64_t period_max_us;				///< Maximal of their latencies
+};
+
+/**
+ * @brief  Files waiting for a worker
+ */
+struct watch_queue_t {
+	std::mutex lock;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	std::deque<struct job_t> jobs;
+	std::set<std::string> pending;		///< Queued or running, seen twice after rescan
+	size_t max;
+	bool done;
+};
+
+/**
+ * @brief  State shared by all workers
+ */
+struct watch_shared_t {
+	struct watch_stats_t stats;
+	struct watch_queue_t queue;
+	const struct watch_opts_t * opts;
+};
+
+static void on_signal(int sig) {
+	UNUSED(sig);
+	g_stop = 1;
+}
+
+/**
+ * @brief  Path of file in directory
+ */
+static std::string join(const char * dir, const std::string & name) {
+	return std::string(dir) + "/" + name;
+}
+
+/**
+ * @brief  Name of BMP written for GIF name, extension .gif is replaced
+ */
+static std::string bmp_name(const std::string & name) {
+	size_t len = name.size();
+	if (len > 4 && strcasecmp(name.c_str() + len - 4, ".gif") == 0)
+		len -= 4;
+	return name.substr(0, len) + ".bmp";
+}
+
+/**
+ * @brief  Convert one file of watched directory and move it away
+ *
+ * BMP is written to a hidden temporary file and renamed when it is
+ * complete, so readers of output directory never see a partial image.
+ *
+ * @return  0 when converted, 1 when it failed, -1 when file is gone
+ */
+static int convert_file(const struct watch_opts_t * opts, const std::string & name,
+		struct gif2bmp_ctx_t * ctx) {
+	std::string in_path = join(opts->dir, name);
+	std::string out_path = join(opts->out_dir, bmp_name(name));
+	std::string tmp_path = join(opts->out_dir, "." + bmp_name(name) + ".part");
+	struct gif2bmp_t status = gif2bmp_t();
+	int res = 1;
+
+	FILE * in_file = fopen(in_path.c_str(), "rb");
+	if (! in_file) {
+		/*
+		 * Already taken by a duplicate event or removed by its owner
+		 */
+		if (errno == ENOENT)
+			return -1;
+		err() << "Cannot open '" << in_path << "': " << strerror(errno) << "\n";
+		return 1;
+	}
+
+	FILE * out_file = fopen(tmp_path.c_str(), "wb");
+	if (out_file) {
+		res = gif2bmp(&status, in_file, out_file, ctx, opts->out);
+		if (fclose(out_file) != 0)
+			res = 1;
+		if (res == 0 && rename(tmp_path.c_str(), out_path.c_str()) != 0) {
+			err() << "Cannot rename to '" << out_path << "': " << strerror(errno) << "\n";
+			res = 1;
+		}
+		if (res != 0)
+			unlink(tmp_path.c_str());
+	} else {
+		err() << "Cannot create '" << tmp_path << "': " << strerror(errno) << "\n";
+	}
+	fclose(in_file);
+
+	std::string moved = join(opts->dir, std::string(res == 0 ? "done/" : "failed/") + name);
+	if (rename(in_path.c_str(), moved.c_str()) != 0)
+		err() << "Cannot move '" << in_path << "' to '" << moved << "': "
+				<< strerror(errno) << "\n";
+
+	if (res != 0)
+		warn() << "Conversion of '" << name << "' failed, moved to failed/\n";
+
+	return res == 0 ? 0 : 1;
+}
+
+/**
+ * @brief  Account finished file
+ */
+static void record(struct watch_stats_t * stats, int res, watch_clock::time_point queued) {
+	uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+			watch_clock::now() - queued).count();
+
+	std::lock_guard<std::mutex> guard(stats->lock);
+	stats->running--;
+	if (res < 0)
+		return;
+	if (res == 0) stats->converted++; else stats->failed++;
+	stats->period_files++;
+	stats->period_latency_us += us;
+	if (us > stats->period_max_us)
+		stats->period_max_us = us;
+}
+
+/**
+ * @brief  Worker thread, owns its own warm decoder storage
+ */
+static void worker(struct watch_shared_t * shared) {
+	struct watch_queue_t * queue = &shared->queue;
+	struct gif2bmp_ctx_t ctx;
+
+	gif2bmp_warm(&ctx, kWatchWarmPixels);
+
+	for (;;) {
+		struct job_t job;
+		{
+			std::unique_lock<std::mutex> guard(queue->lock);
+			while (queue->jobs.empty() && ! queue->done)
+				queue->not_empty.wait(guard);
+			/*
+			 * Files still queued stay in directory, next start picks them up
+			 */
+			if (queue->done)
+				return;
+			job = queue->jobs.front();
+			queue->jobs.pop_front();
+		}
+		queue->not_full.notify_one();
+
+		{
+			std::lock_guard<std::mutex> guard(shared->stats.lock);
+			shared->stats.running++;
+		}
+
+		int res = convert_file(shared->opts, job.name, &ctx);
+		record(&shared->stats, res, job.queued);
+
+		{
+			std::lock_guard<std::mutex> guard(queue->lock);
+			queue->pending.erase(job.name);
+		}
+
+		if (g_limits.memory)
+			gif2bmp_trim(&ctx, kWatchWarmPixels);
+		log_summary();
+	}
+}
+
+/**
+ * @brief  Queue a file, wait while queue is full
+ *
+ * @return  false when stopped while waiting
+ */
+static bool enqueue(struct watch_queue_t * queue, const std::string & name) {
+	if (name.empty() || name[0] == '.')
+		return true;
+
+	{
+		std::unique_lock<std::mutex> guard(queue->lock);
+		if (queue->pending.count(name))
+			return true;
+		while (queue->jobs.size() >= queue->max && ! g_stop)
+			queue->not_full.wait_for(guard, std::chrono::milliseconds(100));
+		if (g_stop)
+			return false;
+
+		struct job_t job = { name, watch_clock::now() };
+		queue->jobs.push_back(job);
+		queue->pending.insert(name);
+	}
+	queue->not_empty.notify_one();
+	return true;
+}
+
+/**
+ * @brief  Queue regular files already in directory
+ *
+ * Done on start and when kernel event queue overflowed, duplicates of
+ * queued files are skipped.
+ *
+ * @return  false when directory cannot be read
+ */
+static bool scan(const char * dir, struct watch_queue_t * queue) {
+	DIR * d = opendir(dir);
+	if (! d) {
+		err() << "Cannot read '" << dir << "': " << strerror(errno) << "\n";
+		return false;
+	}
+
+	struct dirent * entry;
+	while ((entry = readdir(d)) != NULL) {
+		struct stat st;
+		std::string name(entry->d_name);
+		if (name[0] == '.' || stat(join(dir, name).c_str(), &st) != 0 || ! S_ISREG(st.st_mode))
+			continue;
+		if (! enqueue(queue, name))
+			break;
+	}
+
+	closedir(d);
+	return true;
+}
+
+/**
+ * @brief  Log queue depth, throughput and latency since last report
+ */
+static void report(struct watch_shared_t * shared) {
+	size_t queued;
+	{
+		std::lock_guard<std::mutex> guard(shared->queue.lock);
+		queued = shared->queue.jobs.size();
+	}
+
+	struct watch_stats_t * stats = &shared->stats;
+	std::lock_guard<std::mutex> guard(stats->lock);
+	if (! queued && ! stats->running && ! stats->period_files)
+		return;
+
+	char line[256];
+	snprintf(line, sizeof(line), "queued = %zu, running = %" PRIu64 ", finished = %" PRIu64
+			", latency avg = %.1f ms, max = %.1f ms, converted = %" PRIu64 ", failed = %" PRIu64 "\n",
+			queued, stats->running, stats->period_files,
+			stats->period_files ? stats->period_latency_us / 1e3 / stats->period_files : 0.0,
+			stats->period_max_us / 1e3, stats->converted, stats->failed);
+	info() << line;
+
+	stats->period_files = stats->period_latency_us = stats->period_max_us = 0;
+}
+
+/**
+ * @brief  Create subdirectory for moved inputs
+ */
+static bool make_dir(const char * dir, const char * sub) {
+	std::string path = join(dir, sub);
+	if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+		err() << "Cannot create '" << path << "': " << strerror(errno) << "\n";
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief  Read pending inotify events and queue closed files
+ *
+ * @return  false when watching cannot continue
+ */
+static bool read_events(int fd, const char * dir, struct watch_queue_t * queue,
+		std::vector<char> & buf) {
+	ssize_t n = read(fd, &buf[0], buf.size());
+	if (n < 0)
+		return errno == EINTR || errno == EAGAIN;
+
+	for (char * p = &buf[0]; p < &buf[0] + n; ) {
+		struct inotify_event * event = (struct inotify_event *) p;
+		p += sizeof(struct inotify_event) + event->len;
+
+		if (event->mask & IN_Q_OVERFLOW) {
+			warn() << "Too many events, rescanning '" << dir << "'\n";
+			if (! scan(dir, queue))
+				return false;
+		} else if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+			err() << "Watched directory '" << dir << "' was removed or moved!\n";
+			return false;
+		} else if (event->len && ! (event->mask & IN_ISDIR)) {
+			if (! enqueue(queue, event->name))
+				return true;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Convert GIFs put to directory until SIGINT or SIGTERM
+ *
+ * @param opts watch options
+ *
+ * @return  0 on success
+ */
+int watch(const struct watch_opts_t * opts) {
+	struct stat st, out_st;
+	if (stat(opts->out_dir, &out_st) != 0 || ! S_ISDIR(out_st.st_mode)) {
+		err() << "Output directory '" << opts->out_dir << "' does not exist!\n";
+		return 1;
+	}
+	/*
+	 * BMPs renamed into watched directory would be queued as new input
+	 */
+	if (stat(opts->dir, &st) == 0 && st.st_dev == out_st.st_dev && st.st_ino == out_st.st_ino) {
+		err() << "Output directory has to differ from watched one!\n";
+		return 1;
+	}
+	if (! make_dir(opts->dir, "done") || ! make_dir(opts->dir, "failed"))
+		return 1;
+
+	int fd = inotify_init1(IN_CLOEXEC);
+	if (fd < 0) {
+		perror("inotify_init1");
+		return 1;
+	}
+	if (inotify_add_watch(fd, opts->dir, IN_CLOSE_WRITE | IN_MOVED_TO
+			| IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR) < 0) {
+		perror(opts->dir);
+		close(fd);
+		return 1;
+	}
+
+	/*
+	 * No SA_RESTART, poll() and waiting for queue have to be interrupted
+	 */
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	struct watch_shared_t * shared = new struct watch_shared_t;
+	struct watch_stats_t * stats = &shared->stats;
+	struct watch_queue_t * queue = &shared->queue;
+	shared->opts = opts;
+	stats->converted = stats->failed = stats->running = 0;
+	stats->period_files = stats->period_latency_us = stats->period_max_us = 0;
+	queue->max = opts->queue_size;
+	queue->done = false;
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < opts->workers; ++i)
+		workers.push_back(std::thread(worker, shared));
+
+	info() << "Watching '" << opts->dir << "' with " << opts->workers << " workers\n";
+
+	/*
+	 * Watch is set up first, files closed during scan are not missed
+	 */
+	bool ok = scan(opts->dir, queue);
+	std::vector<char> buf(kEventBufferSize);
+	watch_clock::time_point next_report = watch_clock::now()
+			+ std::chrono::seconds(opts->report_interval);
+
+	while (ok && ! g_stop) {
+		int timeout = -1;
+		if (opts->report_interval) {
+			watch_clock::time_point now = watch_clock::now();
+			if (now >= next_report) {
+				report(shared);
+				next_report = now + std::chrono::seconds(opts->report_interval);
+			}
+			int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+					next_report - now).count() + 1;
+			timeout = std::min<int64_t>(ms, INT_MAX);
+		}
+
+		struct pollfd pfd = { fd, POLLIN, 0 };
+		int n = poll(&pfd, 1, timeout);
+		if (n < 0 && errno != EINTR) {
+			perror("poll");
+			ok = false;
+		} else if (n > 0) {
+			ok = read_events(fd, opts->dir, queue, buf);
+		}
+	}
+
+	info() << "Shutting down\n";
+	{
+		std::lock_guard<std::mutex> guard(queue->lock);
+		queue->done = true;
+	}
+	queue->not_empty.notify_all();
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+
+	info() << "Converted " << stats->converted << ", failed " << stats->failed
+			<< ", left " << queue->jobs.size() << " queued\n";
+
+	close(fd);
+	delete shared;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 02:37:19 PM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef WATCH_H_
+#define WATCH_H_
+
+/*
+ * Hot folder (Linux only, uses inotify):
+ *
+ *   <dir>/NAME.gif           closed after writing or moved in -> queued
+ *   <out>/NAME.bmp           result, renamed into place when complete
+ *   <dir>/done/NAME.gif      input converted
+ *   <dir>/failed/NAME.gif    input which could not be converted
+ *
+ * Files starting with a dot are ignored, so writers can upload to
+ * .NAME and rename it when finished.
+ */
+
+/**
+ * @brief  Watch mode options
+ */
+struct watch_opts_t {
+	const char * dir;					///< Directory to take GIFs from
+	const char * out_dir;			///< Directory to write BMPs to
+	unsigned workers;					///< Number of worker threads
+	unsigned queue_size;				///< Max number of files waiting for a worker
+	unsigned report_interval;		///< Seconds between progress reports, 0 disables them
+	const struct gif2bmp_out_t * out;	///< Scale and crop of written images, may be NULL
+};
+
+int watch(const struct watch_opts_t * opts);
+
+#endif // WATCH_H_
@@ -0,0 +1,587 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 01:26:37 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include <algorithm>
+
+#include "writer.h"
+#include "common.h"
+
+const size_t AsyncWriter::kDefaultMaxBytes		= 64 << 20;
+
+const size_t kWriterSlots			= 32;
+const unsigned kWriterThreads		= 4;
+const size_t kNoSlot					= (size_t) -1;
+const size_t kMaxWrite				= 1 << 30;
+
+/**
+ * @brief  Operations of a file submitted to io_uring, in order
+ */
+enum writer_op_t {
+	kOpOpen,
+	kOpWrite,
+	kOpClose
+};
+
+/**
+ * @brief  Constructor
+ *
+ * @param backend how to write files, io_uring falls back to threads when the
+ * kernel does not support it
+ * @param max_bytes memory budget of files waiting to be written
+ */
+AsyncWriter::AsyncWriter(backend_t backend, size_t max_bytes)
+		: m_backend(backend), m_max_bytes(max_bytes), m_bytes(0), m_failed(false),
+		m_current(kNoSlot), m_sync_file(NULL), m_stop(false) {
+	memset(&m_ring, 0, sizeof(m_ring));
+	m_ring.fd = -1;
+
+	if (m_backend == kBackendUring && ! ring_setup(kWriterSlots)) {
+		info() << "io_uring is not available, files are written by threads\n";
+		m_backend = kBackendThreads;
+	}
+
+	if (m_backend == kBackendSync)
+		return;
+
+	m_jobs.resize(kWriterSlots);
+	for (size_t i = kWriterSlots; i > 0; --i)
+		m_free.push_back(i - 1);
+
+	if (m_backend == kBackendThreads)
+		for (unsigned i = 0; i < kWriterThreads; ++i)
+			m_threads.push_back(std::thread(&AsyncWriter::worker, this));
+}
+
+/**
+ * @brief  Destructor, waits for files being written
+ */
+AsyncWriter::~AsyncWriter() {
+	finish();
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_stop = true;
+	}
+	m_queued.notify_all();
+	for (size_t i = 0; i < m_threads.size(); ++i)
+		m_threads[i].join();
+
+	ring_close();
+}
+
+/**
+ * @brief  Parse backend name: uring, threads or sync
+ *
+ * @return  true on success
+ */
+bool AsyncWriter::parse_backend(const char * name, backend_t & backend) {
+	if (strcmp(name, "uring") == 0)
+		backend = kBackendUring;
+	else if (strcmp(name, "threads") == 0)
+		backend = kBackendThreads;
+	else if (strcmp(name, "sync") == 0)
+		backend = kBackendSync;
+	else
+		return false;
+
+	return true;
+}
+
+const char * AsyncWriter::backend_name(backend_t backend) {
+	switch (backend) {
+		case kBackendUring:
+			return "uring";
+		case kBackendThreads:
+			return "threads";
+		default:
+			return "sync";
+	}
+}
+
+/**
+ * @brief  Start output file, only one can be open at a time
+ *
+ * Waits while memory budget is used up by files being written.
+ *
+ * @param name file name
+ * @param size exact size of file
+ *
+ * @return  stream to write file to and pass to close(), NULL on error
+ */
+FILE * AsyncWriter::open(const char * name, size_t size) {
+	if (m_backend == kBackendSync || size == 0 || size > m_max_bytes) {
+		m_sync_file = fopen(name, "wb");
+		if (! m_sync_file)
+			err() << "Failed to create file '" << name << "'\n";
+		return m_sync_file;
+	}
+
+	size_t slot;
+	if (m_backend == kBackendUring) {
+		while (m_backend == kBackendUring && (m_free.empty() || m_bytes + size > m_max_bytes))
+			ring_reap(true);
+		if (m_backend != kBackendUring)
+			return open(name, size);
+		slot = m_free.back();
+		m_free.pop_back();
+		m_bytes += size;
+	} else {
+		std::unique_lock<std::mutex> guard(m_lock);
+		while (m_free.empty() || m_bytes + size > m_max_bytes)
+			m_released.wait(guard);
+		slot = m_free.back();
+		m_free.pop_back();
+		m_bytes += size;
+	}
+
+	struct job_t & job = m_jobs[slot];
+	job.name = name;
+	job.done = 0;
+	job.fd = -1;
+	job.ok = true;
+
+	/*
+	 * one more byte for null byte which fmemopen() stores at the end
+	 */
+	job.data.resize(size + 1);
+	FILE * f = fmemopen(job.data.data(), size + 1, "wb");
+	if (! f) {
+		err() << "Failed to create file '" << name << "'\n";
+		job.data.pop_back();
+		std::lock_guard<std::mutex> guard(m_lock);
+		release(slot, true);
+		return NULL;
+	}
+
+	setvbuf(f, NULL, _IONBF, 0);
+	m_current = slot;
+	return f;
+}
+
+/**
+ * @brief  Finish output file, it is written in background
+ *
+ * @param f stream returned by open()
+ *
+ * @return  false when this or any previous file failed
+ */
+bool AsyncWriter::close(FILE * f) {
+	if (m_current == kNoSlot) {
+		m_sync_file = NULL;
+		return fclose(f) == 0 && ! m_failed;
+	}
+
+	size_t slot = m_current;
+	m_current = kNoSlot;
+
+	std::vector<uint8_t> & data = m_jobs[slot].data;
+	long written = ftell(f);
+	bool ok = (fclose(f) == 0) && written == (long) data.size() - 1;
+	data.pop_back();
+
+	if (m_backend == kBackendUring) {
+		if (! ok) {
+			release(slot, false);
+		} else {
+			ring_push(slot, kOpOpen);
+			ring_reap(false);
+		}
+		return ! m_failed;
+	}
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	if (! ok) {
+		release(slot, false);
+	} else {
+		m_queue.push_back(slot);
+		m_queued.notify_one();
+	}
+	return ! m_failed;
+}
+
+/**
+ * @brief  Make file a hard link to file written earlier
+ *
+ * Links are made by finish(), once the target surely exists.
+ *
+ * @param target file written earlier
+ * @param name link to create
+ *
+ * @return  false when any previous file failed
+ */
+bool AsyncWriter::link(const char * target, const char * name) {
+	if (m_backend == kBackendSync)
+		return link_file(target, name) && ! m_failed;
+
+	m_links.push_back(std::make_pair(std::string(target), std::string(name)));
+	return ! m_failed;
+}
+
+/**
+ * @brief  Wait until all files are written, writer can be used again then
+ *
+ * @return  true if no file failed since last finish()
+ */
+bool AsyncWriter::finish() {
+	if (m_backend == kBackendUring) {
+		while (m_backend == kBackendUring && m_free.size() < m_jobs.size())
+			ring_reap(true);
+	} else if (m_backend == kBackendThreads) {
+		std::unique_lock<std::mutex> guard(m_lock);
+		while (m_free.size() < m_jobs.size())
+			m_released.wait(guard);
+	}
+
+	bool ok = ! m_failed;
+	m_failed = false;
+
+	for (size_t i = 0; i < m_links.size(); ++i)
+		ok = link_file(m_links[i].first.c_str(), m_links[i].second.c_str()) && ok;
+	m_links.clear();
+
+	return ok;
+}
+
+/**
+ * @brief  Return slot of written file, m_lock is held with threads
+ */
+void AsyncWriter::release(size_t slot, bool ok) {
+	struct job_t & job = m_jobs[slot];
+
+	if (! ok) {
+		err() << "Failed to write file '" << job.name << "'\n";
+		m_failed = true;
+	}
+
+	/*
+	 * keep buffers of usual images only, so that idle writer does not hold
+	 * more than the budget
+	 */
+	m_bytes -= job.data.size();
+	if (job.data.capacity() > m_max_bytes / m_jobs.size())
+		std::vector<uint8_t>().swap(job.data);
+
+	m_free.push_back(slot);
+}
+
+/**
+ * @brief  Create and write file by blocking calls
+ *
+ * @return  true on success
+ */
+bool AsyncWriter::write_job(struct job_t & job) {
+	int fd = ::open(job.name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+
+	bool ok = true;
+	while (ok && job.done < job.data.size()) {
+		ssize_t n = write(fd, job.data.data() + job.done, job.data.size() - job.done);
+		if (n > 0)
+			job.done += n;
+		else if (n == 0 || errno != EINTR)
+			ok = false;
+	}
+
+	return (::close(fd) == 0) && ok;
+}
+
+/**
+ * @brief  Make file a hard link to another one, symbolic link when file
+ * system does not support hard links
+ *
+ * @param target existing file
+ * @param name link to create, existing file is replaced
+ *
+ * @return  true on success
+ */
+bool link_file(const char * target, const char * name) {
+	if (unlink(name) != 0 && errno != ENOENT) {
+		err() << "Failed to replace file '" << name << "'\n";
+		return false;
+	}
+
+	if (::link(target, name) != 0 && symlink(target, name) != 0) {
+		err() << "Failed to link file '" << name << "' to '" << target << "'\n";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Worker thread writing queued files
+ */
+void AsyncWriter::worker() {
+	std::unique_lock<std::mutex> guard(m_lock);
+
+	for (;;) {
+		while (m_queue.empty() && ! m_stop)
+			m_queued.wait(guard);
+		if (m_queue.empty())
+			return;
+
+		size_t slot = m_queue.front();
+		m_queue.pop_front();
+
+		guard.unlock();
+		bool ok = write_job(m_jobs[slot]);
+		guard.lock();
+
+		release(slot, ok);
+		m_released.notify_all();
+	}
+}
+
+/**
+ * @brief  Set up io_uring, liburing is not needed
+ *
+ * @param entries size of submission queue, every file has one operation in
+ * flight at most
+ *
+ * @return  true when io_uring supports everything needed
+ */
+bool AsyncWriter::ring_setup(unsigned entries) {
+	struct io_uring_params p;
+
+	memset(&p, 0, sizeof(p));
+	m_ring.fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (m_ring.fd < 0)
+		return false;
+
+	/*
+	 * open, write and close are needed, available since Linux 5.6
+	 */
+	std::vector<uint8_t> buf(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+	struct io_uring_probe * probe = (struct io_uring_probe *) buf.data();
+	static const unsigned kOps[] = { IORING_OP_OPENAT, IORING_OP_WRITE, IORING_OP_CLOSE };
+
+	bool ok = syscall(__NR_io_uring_register, m_ring.fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+	for (size_t i = 0; ok && i < sizeof(kOps) / sizeof(kOps[0]); ++i)
+		ok = kOps[i] <= probe->last_op && (probe->ops[kOps[i]].flags & IO_URING_OP_SUPPORTED);
+
+	if (! ok) {
+		ring_close();
+		return false;
+	}
+
+	m_ring.sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	m_ring.cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		m_ring.sq_size = m_ring.cq_size = std::max(m_ring.sq_size, m_ring.cq_size);
+
+	void * sq = mmap(NULL, m_ring.sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			m_ring.fd, IORING_OFF_SQ_RING);
+	if (sq == MAP_FAILED) {
+		ring_close();
+		return false;
+	}
+	m_ring.sq_ptr = sq;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		m_ring.cq_ptr = sq;
+	} else {
+		void * cq = mmap(NULL, m_ring.cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				m_ring.fd, IORING_OFF_CQ_RING);
+		if (cq == MAP_FAILED) {
+			ring_close();
+			return false;
+		}
+		m_ring.cq_ptr = cq;
+	}
+
+	m_ring.sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	void * sqes = mmap(NULL, m_ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			m_ring.fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED) {
+		ring_close();
+		return false;
+	}
+	m_ring.sqes = (struct io_uring_sqe *) sqes;
+
+	char * s = (char *) m_ring.sq_ptr;
+	char * c = (char *) m_ring.cq_ptr;
+	m_ring.sq_head = (unsigned *) (s + p.sq_off.head);
+	m_ring.sq_tail = (unsigned *) (s + p.sq_off.tail);
+	m_ring.sq_mask = (unsigned *) (s + p.sq_off.ring_mask);
+	m_ring.sq_array = (unsigned *) (s + p.sq_off.array);
+	m_ring.cq_head = (unsigned *) (c + p.cq_off.head);
+	m_ring.cq_tail = (unsigned *) (c + p.cq_off.tail);
+	m_ring.cq_mask = (unsigned *) (c + p.cq_off.ring_mask);
+	m_ring.cqes = (struct io_uring_cqe *) (c + p.cq_off.cqes);
+
+	return true;
+}
+
+/**
+ * @brief  Unmap rings and close io_uring
+ */
+void AsyncWriter::ring_close() {
+	if (m_ring.sqes)
+		munmap(m_ring.sqes, m_ring.sqes_size);
+	if (m_ring.cq_ptr && m_ring.cq_ptr != m_ring.sq_ptr)
+		munmap(m_ring.cq_ptr, m_ring.cq_size);
+	if (m_ring.sq_ptr)
+		munmap(m_ring.sq_ptr, m_ring.sq_size);
+	if (m_ring.fd >= 0)
+		::close(m_ring.fd);
+
+	memset(&m_ring, 0, sizeof(m_ring));
+	m_ring.fd = -1;
+}
+
+/**
+ * @brief  Queue next operation of file, submitted by ring_reap()
+ */
+void AsyncWriter::ring_push(size_t slot, int op) {
+	struct job_t & job = m_jobs[slot];
+	unsigned tail = *m_ring.sq_tail;
+	unsigned index = tail & *m_ring.sq_mask;
+	struct io_uring_sqe * sqe = &m_ring.sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	switch (op) {
+		case kOpOpen:
+			sqe->opcode = IORING_OP_OPENAT;
+			sqe->fd = AT_FDCWD;
+			sqe->addr = (uintptr_t) job.name.c_str();
+			sqe->len = 0644;
+			sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+			break;
+		case kOpWrite:
+			sqe->opcode = IORING_OP_WRITE;
+			sqe->fd = job.fd;
+			sqe->addr = (uintptr_t) (job.data.data() + job.done);
+			sqe->len = std::min(job.data.size() - job.done, kMaxWrite);
+			sqe->off = job.done;
+			break;
+		default:
+			sqe->opcode = IORING_OP_CLOSE;
+			sqe->fd = job.fd;
+			break;
+	}
+	sqe->user_data = slot;
+	job.op = op;
+
+	m_ring.sq_array[index] = index;
+	__atomic_store_n(m_ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+	m_ring.pending++;
+}
+
+/**
+ * @brief  Submit queued operations and handle completed ones
+ *
+ * @param wait wait for at least one completion
+ */
+void AsyncWriter::ring_reap(bool wait) {
+	do {
+		unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+		int n = syscall(__NR_io_uring_enter, m_ring.fd, m_ring.pending, wait ? 1 : 0, flags, NULL, 0);
+		if (n >= 0)
+			m_ring.pending -= std::min((unsigned) n, m_ring.pending);
+		else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			warn() << "Failed to submit writes (" << strerror(errno)
+					<< "), files are written synchronously\n";
+			ring_fallback();
+			return;
+		}
+
+		unsigned head = *m_ring.cq_head;
+		unsigned tail = __atomic_load_n(m_ring.cq_tail, __ATOMIC_ACQUIRE);
+		for (; head != tail; ++head) {
+			struct io_uring_cqe * cqe = &m_ring.cqes[head & *m_ring.cq_mask];
+			ring_complete(cqe->user_data, cqe->res);
+		}
+		__atomic_store_n(m_ring.cq_head, head, __ATOMIC_RELEASE);
+
+		/*
+		 * operations queued by completions are only submitted, not waited for
+		 */
+		wait = false;
+	} while (m_ring.pending);
+}
+
+/**
+ * @brief  Give up io_uring after it failed, write files in flight by
+ * blocking calls
+ *
+ * Files opened later are written synchronously.
+ */
+void AsyncWriter::ring_fallback() {
+	ring_close();
+	m_backend = kBackendSync;
+
+	std::vector<bool> idle(m_jobs.size(), false);
+	for (size_t i = 0; i < m_free.size(); ++i)
+		idle[m_free[i]] = true;
+
+	for (size_t slot = 0; slot < m_jobs.size(); ++slot) {
+		if (idle[slot] || slot == m_current)
+			continue;
+
+		/*
+		 * descriptor with close in flight may be closed already and reused
+		 */
+		struct job_t & job = m_jobs[slot];
+		if (job.fd >= 0 && job.op != kOpClose)
+			::close(job.fd);
+		job.fd = -1;
+		job.done = 0;
+		release(slot, job.ok && write_job(job));
+	}
+}
+
+/**
+ * @brief  Handle completed operation of file, queue the next one
+ *
+ * @param slot file
+ * @param res result of operation, negative errno on error
+ */
+void AsyncWriter::ring_complete(size_t slot, int res) {
+	struct job_t & job = m_jobs[slot];
+
+	switch (job.op) {
+		case kOpOpen:
+			if (res < 0) {
+				release(slot, false);
+			} else {
+				job.fd = res;
+				ring_push(slot, kOpWrite);
+			}
+			break;
+		case kOpWrite:
+			if (res == -EINTR || res == -EAGAIN) {
+				ring_push(slot, kOpWrite);
+				break;
+			}
+			if (res > 0)
+				job.done += res;
+			else
+				job.ok = false;
+
+			if (job.ok && job.done < job.data.size())
+				ring_push(slot, kOpWrite);
+			else
+				ring_push(slot, kOpClose);
+			break;
+		default:
+			release(slot, job.ok && res >= 0);
+			break;
+	}
+}
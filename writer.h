@@ -0,0 +1,132 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 01:26:37 AM
+ *        @author   Fridolin Pokorny <fridex.devel@gmail.com>
+ *
+ ***********************************************************************
+ */
+
+#ifndef WRITER_H_
+#define WRITER_H_
+
+#include <inttypes.h>
+#include <cstdio>
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * @brief  Writer of output files in background
+ *
+ * A file is written to a memory buffer by stdio first and created and written
+ * to disk while the next one is being decoded. With io_uring, creation, writes
+ * and closing of many files are submitted in batches from the calling thread;
+ * otherwise a few threads do blocking writes. Files bigger than the memory
+ * budget are written synchronously.
+ */
+class AsyncWriter {
+public:
+	enum backend_t {
+		kBackendSync,				///< Plain stdio files
+		kBackendThreads,			///< Blocking writes in worker threads
+		kBackendUring				///< io_uring, threads when not available
+	};
+
+	AsyncWriter(backend_t backend, size_t max_bytes = kDefaultMaxBytes);
+	~AsyncWriter();
+
+	FILE * open(const char * name, size_t size);
+	bool close(FILE * f);
+	bool link(const char * target, const char * name);
+	bool finish();
+
+	backend_t backend() const { return m_backend; }
+
+	static bool parse_backend(const char * name, backend_t & backend);
+	static const char * backend_name(backend_t backend);
+
+	static const size_t kDefaultMaxBytes;
+
+private:
+	AsyncWriter(const AsyncWriter &);
+	AsyncWriter & operator=(const AsyncWriter &);
+
+	/**
+	 * @brief  File being written, slots are reused
+	 */
+	struct job_t {
+		std::string name;
+		std::vector<uint8_t> data;
+		size_t done;				///< Bytes written
+		int fd;
+		int op;						///< Operation in flight (io_uring)
+		bool ok;						///< No write failed
+	};
+
+	/**
+	 * @brief  Mapped io_uring rings
+	 */
+	struct ring_t {
+		int fd;
+		void * sq_ptr;
+		void * cq_ptr;
+		size_t sq_size;
+		size_t cq_size;
+		struct io_uring_sqe * sqes;
+		size_t sqes_size;
+		unsigned * sq_head;
+		unsigned * sq_tail;
+		unsigned * sq_mask;
+		unsigned * sq_array;
+		unsigned * cq_head;
+		unsigned * cq_tail;
+		unsigned * cq_mask;
+		struct io_uring_cqe * cqes;
+		unsigned pending;			///< Queued submissions
+	};
+
+	bool ring_setup(unsigned entries);
+	void ring_close();
+	void ring_push(size_t slot, int op);
+	void ring_reap(bool wait);
+	void ring_complete(size_t slot, int res);
+	void ring_fallback();
+
+	void worker();
+	bool write_job(struct job_t & job);
+	void release(size_t slot, bool ok);
+
+	backend_t m_backend;
+	size_t m_max_bytes;			///< Memory budget of buffered files
+	size_t m_bytes;				///< Bytes of buffered files
+	bool m_failed;
+
+	std::vector<struct job_t> m_jobs;
+	std::vector<size_t> m_free;	///< Free slots of m_jobs
+	size_t m_current;				///< Slot being filled by caller
+	FILE * m_sync_file;			///< File written synchronously, not buffered
+	std::vector<std::pair<std::string, std::string> > m_links;	///< Made by finish()
+
+	struct ring_t m_ring;
+
+	std::vector<std::thread> m_threads;
+	std::deque<size_t> m_queue;	///< Slots to be written by threads
+	std::mutex m_lock;
+	std::condition_variable m_queued;
+	std::condition_variable m_released;
+	bool m_stop;
+}; // class AsyncWriter
+
+bool link_file(const char * target, const char * name);
+
+#endif // WRITER_H_